@@ -1,890 +1,4156 @@
-/******************************************************************************************
- *                                                                                        *
- *                   Mid Year Programming Contest: Image Data Processing                  *
- *                 Kyocera Document Solutions Development Philippines, Inc.               *
- *                                                                                        *
- ******************************************************************************************/
-
-/*
- *=========================================================================================
- *                                     Description
- *-----------------------------------------------------------------------------------------
- *  This program performs the basic image processing techniques but can only read a     
- *  P6 PPM image format. This can do rescale with respect to aspect     
- *  ratio, image rotation, P6 PPM to P5 PGM (grayscale) and P6 PPM to P4 PBM (bilevel)  
- *  conversion, and image flip (vertically and horizontally).                           
- *                                                                                      
- *  For PPM information: http://netpbm.sourceforge.net/doc/ppm.html
- *-----------------------------------------------------------------------------------------
- *                                   Revision History
- *----------+---------------------------+--------------------------------------------------
- * 08/08/18 |   Philogene Kyle Dimpas   |   Updated the documentation style and added
- *          |                           |   comment #Philogene Kyle Dimpas in the header
- *----------+---------------------------+--------------------------------------------------
- * 07/27/18 |   Philogene Kyle Dimpas   |   Finished the Program 
- *=========================================================================================
-*/
-
-//=========================================================================================
-//                                     Definitions                       
-//=========================================================================================
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <math.h>
-
-#define PXL unsigned char
-#define PGM unsigned char
-#define PBM unsigned char
-#define M_PI 3.14159265358979323846
-
-#define EXIT(...)                                        \
-{   fprintf(stderr, ""__VA_ARGS__);                      \
-    if(fpIn != NULL) fclose(fpIn);                       \
-    if(outImg.format.ppm != NULL)free(outImg.format.ppm);\
-    if(srcImg.format.ppm != NULL)free(srcImg.format.ppm);\
-    return EXIT_FAILURE;                                 \
-}
-
-typedef struct{
-    PXL  R;
-    PXL  G;
-    PXL  B;
-}PPM;
-
-typedef union{
-    PPM *ppm;
-    PGM *pgm;
-    PBM *pbm;
-}fileFormat;
-
-typedef struct{
-    fileFormat format;
-    unsigned int size;
-}fileType;
-
-//=========================================================================================
-//                                     Global Variables                  
-//=========================================================================================
-int  headerInfo[3]; 
-char fType[2];
-
-//=========================================================================================
-//                                   Function Prototypes                     
-//=========================================================================================
-
-int    allocMem(fileType *);
-int    writeFile(fileType, char []);
-int    parseOptions(char [], int *);
-int    sortOptions(int, int*, char *[]);
-int    rescaleWidth(fileType *, fileFormat *, int, int, int );
-int    rotateImage(fileType *, fileFormat *, int, int, int );
-void   flipHorizontal(fileType *, fileFormat *, int ,int );
-void   flipVertical(fileType *, fileFormat *,  int ,int );
-void   toGrayScale(fileFormat *, fileFormat *, int ,int );
-void   dithering(fileFormat *, fileFormat *, int , int );
-void   rotate90(fileType *, fileFormat *, int , int );
-void   readHeader(FILE *);
-void   options();
-double round (double );
-
-//=========================================================================================
-//                                     Main Function                 
-//=========================================================================================
-int main(int argc, char *argv[])
-{   
-    fileType     outImg;
-    fileType     srcImg;
-    FILE        *fpIn     = NULL;
-    char        *filename = NULL;
-    int          optionIdx[10];
-    int          i;
-    int          param;
-
-    outImg.format.ppm = NULL;
-    srcImg.format.ppm = NULL;
-    outImg.size = srcImg.size = 0;
-
-    if(argc < 3){
-        options();
-        exit(1);
-    }
-    
-    if((i = sortOptions(argc, optionIdx, argv)) == 0){
-        EXIT();
-    }else if(i == -1){
-        options();
-        EXIT("ERROR: -options invalid");
-        
-    }
-    filename = argv[argc-1];
-    fpIn = fopen(filename,"rb");
-
-    if(fpIn == NULL){
-        EXIT("ERROR: File not found");
-    }
-
-    fType[0] = fgetc(fpIn);
-    fType[1] = fgetc(fpIn);
-    if('P' != fType[0] || '6' != fType[1]){
-        EXIT("ERROR: File not PPM P6 format");
-    }
-
-    readHeader(fpIn);
-    if(!allocMem(&srcImg)){
-        EXIT("ERROR: Source image cannot allocate memory");
-    }
-    
-    if(!fread(srcImg.format.ppm,1,sizeof(PPM)*headerInfo[0]*headerInfo[1],fpIn)){
-        EXIT("ERROR: fread cannot read source image");
-    }
-    if(!allocMem(&outImg)){
-        EXIT("ERROR: Cannot create new file");
-    }
-
-    //planning to revise and remove the switch
-    for(i=0 ; i < argc-2 ; i++){
-        switch (parseOptions(argv[optionIdx[i]], &param)){
-            case 1:
-                flipVertical(&outImg, &srcImg.format, headerInfo[0], headerInfo[1]); break;
-            case 2:
-                flipHorizontal(&outImg, &srcImg.format, headerInfo[0], headerInfo[1]); break;
-            case 3:
-                if(!rescaleWidth(&outImg, &srcImg.format, param, headerInfo[0], headerInfo[1])){
-                    EXIT("ERROR: maximum dimension ( 9999 x 9999 )");
-                }
-                break;
-            case 4:
-                if(!rotateImage(&outImg, &srcImg.format, param, headerInfo[0], headerInfo[1])){
-                    EXIT("ERROR: failed to allocate memory for rotate image");
-                }
-                break;
-            case 5:
-                fType[1] = '4';
-                allocMem(&outImg);
-                toGrayScale(&srcImg.format, &srcImg.format, headerInfo[0], headerInfo[1]);
-                dithering(&outImg.format, &srcImg.format,headerInfo[0], headerInfo[1]);
-                break;
-            case 6: 
-                fType[1] = '5';
-                allocMem(&outImg);
-                toGrayScale(&outImg.format, &srcImg.format, headerInfo[0], headerInfo[1]);
-                break;
-            default: options(); EXIT(); break;
-        }
-
-        if(fType[1] == '6'){
-            free(srcImg.format.ppm);
-        }
-        
-        if(!allocMem(&srcImg)){
-            EXIT("ERROR: Failed to allocate memory for output copy");
-        }
-
-        memcpy(srcImg.format.ppm, outImg.format.ppm, outImg.size);
-        printf("%s ", argv[optionIdx[i]]);
-    }
-    if(!writeFile(outImg,filename)){
-        EXIT("\nERROR: failed to write the file\n");
-    }
-
-    EXIT("done!");
-    return 0;
-}
-
-
-
-//=========================================================================================
-//                                      Functions                
-//=========================================================================================
-
-
-/*
- *=================================================================================
- *
- *  int parseOptions(char [], int* )
- * 
- *  Description:
- *   Parses the given string option.
- *  Return: 
- *   This will return an integer based on its corresponding type; otherwise its 0.                    
- *
- *=================================================================================
- */
-int parseOptions(char option[], int *param)
-{
-    int i;
-    int j;
-    int type = -1;
-    int newWidth = 0;
-    char buff[10];
-    
-    for(i = 1 ; option[i] != '\0' && type ; i++){
-
-        switch(option[i]){
-            //-fv is type 1 and -fh is 2        
-            case 'f':
-
-                if((option[++i] == 'v' || option[i] == 'h') && option[i+1] == '\0'){
-                    type = (option[i] == 'v')? 1: 2;
-                }
-                break;
-            //-w is type 3 and -r is 4
-            case 'w': 
-            case 'r':
-                //limits number to 12 digits only
-                for(j=0, ++i ; j < 12 && option[i] != '\0' && isdigit(option[i]) ; j++, i++){
-                    buff[j] = option[i];
-                }
-
-                if(option[i] == '\0' && j != 0){
-                    *param = atoi(buff);
-                    type = (option[1] == 'w')?3:4;
-                }else{
-                    printf("ERROR: invalid input");
-                    type = 0;
-                }
-                //check if width is greater than 0
-                
-                type = (type == 3 && *param < 1 )? 0: type;
-                type = (type == 4 && *param > 359)? 0: type;
-
-                i = strlen(option) - 1;
-                break;
-            //-mono is type 5 and -gray is 6
-            case 'm': 
-            case 'g': 
-            
-                if(strcmp(option,"-mono") == 0){
-                    type = 5;
-                }else if(strcmp(option,"-gray") == 0){
-                    type = 6;
-                }
-            
-                i = strlen(option)-1;
-                break;
-            
-            default : type = 0;  break;
-        }
-    }
-
-    return type;
-
-}
-/*
- *=================================================================================
- *
- *  int sortOptions(int , int *, char *[])
- * 
- *  Description:
- *    Sorts the options according to it's heirarchy.
- *    heirarchy of -options: -w (-r -f) -gray -mono. (-r & -f are in same heirarchy)          
- *  Return:
- *    returns 1 if successful; else 0.                    
- *
- *=================================================================================
- */
-int sortOptions(int size, int *options, char *argv[])
-{
-    
-    unsigned char   optionSet = 0;  //128 = w, 64 = r, 32 = f, 16 = g, 8 = m, 1 = flag swap f and r
-    char            str[100];
-    int             i;
-    int             idx;
-    int             cnt;
-    int             mask = 128;
-    int             invalidFlag = 0;
-    char            prioOptions[6] = {'w', 'r', 'f', 'g', 'm'};
-    
-    for(cnt = i = 0 ; i < 6 && cnt < size - 2 ; i ++, mask >>= 1){
-
-        for(idx = 1 ; idx < size - 1; idx++){
-            if(*argv[idx] != '-'){
-                printf("ERROR: -options invalid");
-                return 0;
-            }
-            if(*(argv[idx] + 1) == prioOptions[i]){
-                //check if the -option is not yet in the set
-                if((optionSet & mask) == mask){
-                    printf("ERROR: duplicate options");
-                    return 0;
-                }
-                if(i == 4 && (optionSet & 16) == 16){
-                    printf("ERROR: conflict options (mono and gray)");
-                    return 0;
-                }
-
-                options[cnt++] = idx;
-                optionSet |= mask;
-                //ideally rotate and flip can be exchanged but rotate is always be first
-                //this condition will swap flip over rotate if flip was inputted first by the user
-                if( (optionSet & 96) == 96 && (optionSet & 1) != 1){
-                    if(idx < options[cnt - 2]){
-                        options[cnt-2] = options[cnt-2] + options[cnt-1];
-                        options[cnt-1] = options[cnt-2] - options[cnt-1];
-                        options[cnt-2] = options[cnt-2] - options[cnt-1];
-                    }
-                    //check only once
-                    optionSet |= 1;
-                }
-            }
-        }
-
-    }
-    
-    return (cnt > 0 && cnt == size-2)? 1 : -1;  
-}
-
-/*
- *=================================================================================
- *
- * int writeFile(fileType, char [])
- * 
- * Description:
- *   Creates the image based on the final content of the memory 
- * Return:
- *  returns 1 if successful; else 0                               
- *
- *=================================================================================
- */
-int writeFile(fileType out, char srcName[])
-{
-    FILE    *fp;
-    char    filename[50];
-
-    //copy filename without .extension
-    strncpy(filename, srcName, strlen(srcName)-4);
-    filename[strlen(srcName)-4] = '\0';
-
-    switch(fType[1]){
-        case '6': strcat(filename,".ppm.out"); 
-                  fp = fopen(filename,"wb");
-                  break;
-        case '5': strcat(filename,".pgm.out"); 
-                  fp = fopen(filename,"wb");
-                  break;
-        case '4': strcat(filename,".pbm.out"); 
-                  fp = fopen(filename,"wb");
-                  break;
-        default : fp = NULL;
-                  break;
-    }
-
-    if(fp == NULL){
-        printf("ERROR: cannot create new file");
-        return 0;
-    }
-    //writes the header of the file
-    if(!fprintf(fp,"P%c\n#Philogene Kyle Dimpas\n"
-        "%d %d\n",fType[1],headerInfo[0],headerInfo[1])){
-        printf("ERROR: Unable to write into the file");
-        fclose(fp);
-        return 0;
-    }
-    //writes maximum color value
-    if(fType[1] != '4'){
-        fprintf(fp,"%d\n", headerInfo[2]);
-    }
-    fwrite(out.format.ppm,1,out.size,fp);
-    
-    fclose(fp);
-    return 1;
-}
-
-/*
- *=================================================================================
- *
- * int allocMem(fileType *)
- * 
- * Description:
- *   Allocates a chunk of memory based on the file format.  
- * Return:
- *   returns 1 if successful; else 0.                   
- *            
- *=================================================================================
- */
-int allocMem(fileType *out)
-{
-    if(headerInfo[0] >= 10000 || headerInfo[1] >= 10000){
-        return 0;
-    }
-
-    //allocates memory accoring to its file type
-    switch(fType[1]){
-        case '6':
-            out->size = sizeof(PPM)*headerInfo[0]*headerInfo[1]; 
-            out->format.ppm = (PPM*)malloc(out->size);
-            break;
-        case '5':
-            out->size = sizeof(PGM)*headerInfo[0]*headerInfo[1];
-            out->format.pgm = (PGM*)realloc(out->format.ppm, out->size);
-            break;
-        case '4': 
-            out->size = sizeof(PBM)*(headerInfo[1]*headerInfo[0]);// + (sizeof(PBM)*headerInfo[0]*headerInfo[1]) % 8 != 0);
-            out->format.pbm = (PBM*)realloc(out->format.ppm, out->size);
-            break;
-
-        default : 
-            printf("ERROR: wrong file format");
-            return 0;
-    }
-
-    return (out->format.ppm == NULL) ? 0: 1;
-}
-
-/*
- *=================================================================================
- *
- * void readHeader(FILE *)
- * 
- * Description:
- *   reads the header of the file and parse the content of the header                                                               
- *
- *=================================================================================
- */
-void readHeader(FILE *fp)
-{
-    char    ch = 0;
-    int     i = 0;
-    int     cnt = 0;
-    int     isComment = 0;
-    int     isValue = 0;
-    char    buff[10];
-    
-    //to get the 3 data (width, height, maximum size)   
-    while(cnt <3){
-        ch = fgetc(fp);
-        //check the #comment strings                                
-        if(ch != '#' && isComment != 1){
-            //find the first character of the data
-            if(!isspace(ch)){
-                buff[i++] = ch;
-            //last character of the data and then add '\0'  
-            }else if(i > 0){
-                buff[i] = '\0';
-                //stores integer data in headerInfo
-                headerInfo[cnt++] = atoi(buff);
-                //this indicates that no data is found yet
-                i = 0;
-            }
-        }else{
-            //flags the start and the end of the comment
-            isComment = (ch == 10)? 0: 1;
-        }   
-    }
-}
-
-/*
- *=================================================================================
- *
- * int rescaleWidth(fileType *, fileFormat *, int , int, int )
- * 
- * Description:
- *    resize the image given new width and P6 image using bilinear interpolation.
- * Return:
- *  returns 1 if successful; else 0.    
- *
- *=================================================================================
- */
-int rescaleWidth(fileType *out, fileFormat *src, int newWidth, int width, int height)
-{
-    PPM     pxl[4];
-    PPM     temp;
-    int     x;
-    int     y;
-    int     xDiff;
-    int     yDiff;
-    int     index;
-    int     i;
-    int     j;
-    int     offset = 0;
-    float   xRatio;
-    float   yRatio;
-    
-    //free the pre allocated memory to reallocate bigger memory
-    free(out->format.ppm);
-    out->format.ppm = NULL;
-    
-    headerInfo[0] = newWidth;
-    headerInfo[1] = (int) ceil((float)height / width * newWidth); 
-
-    if(!allocMem(out)){
-        return 0;
-    }
-
-    xRatio = ( (float) width - 1) / headerInfo[0];
-    yRatio = ( (float) height - 1) / headerInfo[1];
-    
-    for(i = 0; i < headerInfo[1]; i++ ){
-        for(j=0; j < headerInfo[0]; j++){
-
-            x = xRatio * j;
-            y = yRatio * i;
-            xDiff = (xRatio * j) - x;
-            yDiff = (yRatio * i) - y;
-
-            index = (y * width + x);
-            
-            pxl[0] = *(src->ppm + index);
-            pxl[1] = *(src->ppm + index + 1);
-            pxl[2] = *(src->ppm + index + width);
-            pxl[3] = *(src->ppm + index + width + 1);
-
-            //using bilinear interpolation algorithm for R G B
-            
-            temp.R = (PXL) (pxl[0].R * (1 - xDiff) * (1 - yDiff) + pxl[1].R * xDiff * (1 - yDiff) +
-                    pxl[2].R * yDiff * (1 - xDiff) + pxl[3].R * (xDiff * yDiff));
-
-            temp.G = (PXL) (pxl[0].G * (1 - xDiff) * (1 - yDiff) + pxl[1].G * xDiff * (1 - yDiff) +
-                    pxl[2].G * yDiff * (1 - xDiff) + pxl[3].G * (xDiff * yDiff));
-
-            temp.B = (PXL) (pxl[0].B * (1 - xDiff) * (1 - yDiff) + pxl[1].B * xDiff * (1 - yDiff) +
-                    pxl[2].B * yDiff * (1 - xDiff) + pxl[3].B * (xDiff * yDiff));
-
-            memcpy(out->format.ppm + offset++, &temp, sizeof(PPM));
-        }
-    }
-    return 1;
-}
-
-//=================================================================================
-// Function round() rounds the value. This is used in function rotateImage().     
-//=================================================================================
-double round(double val)
-{    
-    return floor(val + 0.5);
-}
-
-//=================================================================================
-// Function rotate90() rotates the image in 90 degrees.                           
-//=================================================================================
-void rotate90(fileType *out, fileFormat *src, int width, int height)
-{
-    PPM *temp;
-    int i;
-    int j;
-
-    temp = out->format.ppm;
-    //the 2 loops for the rotation
-    for(i =0 ; i < width ; i++){
-        for(j = height-1 ; j>=0 ; j--){
-            memcpy(out->format.ppm++, src->ppm + i + j*width, sizeof(PPM));
-        }
-    }
-    out->format.ppm = temp;
-}
-
-/*
- *=================================================================================
- *
- * int rotateImage(fileType *, fileFormat *, int, int ,int)
- * 
- * Description:
- *   rotates P6 PPM image using biliniear interpolation   
- * Return:
- *   returns 1 if successful; else 0;                         
- *
- *=================================================================================
- */
-int rotateImage(fileType *out, fileFormat *src, int angle, int width, int height)
-{
-    const double cnAngle = (angle * M_PI / 180);
-    int          i;
-    int          j;
-    int          x;
-    int          y;
-    int          iFloorX;
-    int          iCeilingX;
-    int          iFloorY;
-    int          iCeilingY;
-    int          iCentreX;
-    int          iCentreY;
-    int          iDestCentreX;
-    int          iDestCentreY;
-    int          iWidth;
-    int          iHeight;
-    double       fDistance;
-    double       fPolarAngle;
-    double       fTrueX;
-    double       fTrueY;
-    double       fDeltaX;
-    double       fDeltaY;
-    double       fTopRed;
-    double       fTopGreen;
-    double       fTopBlue;
-    double       fBottomRed;
-    double       fBottomGreen;
-    double       fBottomBlue;
-    PPM          color[4];
-    PPM          tempRGB;
-
-
-    //pythagorean theorem
-    //sin(angle) * hypotenuse + cos(angle) * hypotenuse 
-    iWidth  = ceil( abs(sin(cnAngle) * headerInfo[1]) + abs(cos(cnAngle) * headerInfo[0]));
-    iHeight = ceil( abs(sin(cnAngle) * headerInfo[0]) + abs(cos(cnAngle) * headerInfo[1]));
-
-    iCentreX = width / 2;
-    iCentreY = height / 2;
-
-    iDestCentreX = iWidth / 2;
-    iDestCentreY = iHeight / 2;
-    headerInfo[0] = iWidth;
-    headerInfo[1] = iHeight;
-
-    free(out->format.ppm);
-    out->format.ppm = NULL;
-    if(!allocMem(out)){
-        return 0;
-    }
-    
-    //angles 0, 180, 90 and 270 should have a different function and should not reuse flips and rotate90
-    //planning to revise
-    if(angle == 0){
-        memcpy(out->format.ppm, src->ppm, sizeof(PPM)*width*height);
-        return 1;
-    }
-    if(angle == 180){
-        flipHorizontal(out, src, width, height);
-        memcpy(src->ppm, out->format.ppm, out->size);
-        flipVertical(out, src, width, height);
-        return 1;
-    }
-    if(angle == 90){
-        rotate90(out, src, width, height);
-        return 1;
-    }
-    if(angle == 270){
-        rotate90(out, src, width, height);
-        memcpy(src->ppm, out->format.ppm, out->size);
-        flipVertical(out,src,height,width);
-        memcpy(src->ppm, out->format.ppm, out->size);
-        flipHorizontal(out,src,height,width);
-        return 1;
-    }
-
-
-    memset(out->format.ppm, 0, out->size);
-    
-    for(i=0 ; i < iHeight ; ++i){
-        
-        for(j=0 ; j < iWidth ; ++j){
-            x = j - iDestCentreX;
-            y = iDestCentreY - i;
-
-            fDistance = sqrt( x * x + y * y);
-            fPolarAngle = 0.0;
-            if(x == 0){
-                fPolarAngle = (y < 0)? 1.5 * M_PI : 0.5 * M_PI;
-            }else{
-                fPolarAngle = atan2(y,x);
-            }
-
-            fPolarAngle += cnAngle;
-            
-            fTrueX = fDistance * cos(fPolarAngle);
-            fTrueY = fDistance * sin(fPolarAngle);
-
-            fTrueX +=iCentreX;
-            fTrueY = iCentreY - fTrueY;
-
-            iFloorX = floor(fTrueX);
-            iFloorY = floor(fTrueY);
-            iCeilingX = ceil(fTrueX);
-            iCeilingY = ceil(fTrueY);
-            
-            // check bounds
-            if (iFloorX < 0 || iCeilingX < 0 || iFloorX >= width || iCeilingX >= width || iFloorY < 0 || iCeilingY < 0 || iFloorY >= height || iCeilingY >= height) continue;
-            
-            fDeltaX = fTrueX - iFloorX;
-            fDeltaY = fTrueY - iFloorY;
-
-            //colors from topleft, topright, bottomleft and bottomright respectively
-            color[0] = *(src->ppm + iFloorX + iFloorY * width);
-            color[1] = *(src->ppm + iCeilingX + iFloorY * width);
-            color[2] = *(src->ppm + iFloorX + iCeilingY * width);
-            color[3] = *(src->ppm + iCeilingX +  iCeilingY * width);
-            
-            // linearly interpolate horizontally between top neighbours
-            fTopRed = (1 - fDeltaX) * color[0].R + fDeltaX * color[1].R;
-            fTopGreen = (1 - fDeltaX) * color[0].G + fDeltaX * color[1].G;
-            fTopBlue = (1 - fDeltaX) * color[0].B + fDeltaX * color[1].B;
-
-            // linearly interpolate horizontally between bottom neighbours
-            fBottomRed = (1 - fDeltaX) * color[2].R + fDeltaX * color[3].R;
-            fBottomGreen = (1 - fDeltaX) * color[2].G + fDeltaX * color[3].G;
-            fBottomBlue = (1 - fDeltaX) * color[2].B + fDeltaX * color[3].B;
-
-            // linearly interpolate vertically between top and bottom interpolated results
-            tempRGB.R = round((1 - fDeltaY) * fTopRed + fDeltaY * fBottomRed);
-            tempRGB.G = round((1 - fDeltaY) * fTopGreen + fDeltaY * fBottomGreen);
-            tempRGB.B = round((1 - fDeltaY) * fTopBlue + fDeltaY * fBottomBlue);
-
-            memcpy(out->format.ppm + j +  i*iWidth, &tempRGB, sizeof(PPM));
-            
-        }
-    }
-
-    return 1;
-}
-
-/*
- *=================================================================================
- *
- * void toGrayScale(fileFormat *out, fileFormat *, int, int )
- * 
- * Description:
- *   converts 3 bytes RGB pixel to 1 byte grayscale pixel  
- *                                    
- *=================================================================================
- */
-void toGrayScale(fileFormat *out, fileFormat *src, int width, int height)
-{
-    int     i;
-    int     size;
-    PGM     grey;
-    PPM     *rgb;
-
-    size = height*width;
-    for(i=0; i < size; i++){
-        //gets the RGB pixels sequentially 
-        rgb = src->ppm + i;
-        //converts 3 bytes RGB pixel to 1 byte grayscaled pixel
-        grey = ((rgb->R * 299) + (rgb->G * 587) + (rgb->B * 114))/1000;
-        memcpy(out->pgm + i, &grey,sizeof(PGM));
-    }
-}
-
-/*
- *=================================================================================
- *
- * void dithering()
- * 
- * Description:
- *   converts P5 PGM to P4 PBM using ordered dithering technique (bayer 8x8)
- *                                    
- *=================================================================================
- */
-void dithering(fileFormat *out, fileFormat *src, int width, int height)
-{
-    int     i;
-    int     j;
-    int     iMtrx;
-    int     jMtrx;
-    int     n = 128;
-    int     error = 0;
-    PBM     pbm;
-    PBM     *temp;
-    PBM     *oldPxl;
-#if 0
-    int     bayer[8][8] = { { 96,  40,  48, 104, 140, 188, 196, 148},
-                            { 32,   4,   8,  56, 180, 236, 244, 204},
-                            { 88,  24,  16,  64, 172, 228, 252, 212},
-                            {120,  80,  72, 112, 132, 164, 220, 156},
-                            {136, 184, 192, 144, 100,  44,  52, 108},
-                            {176, 232, 240, 200,  36,   4,  12,  60},
-                            {168, 224, 248, 208,  92,  28,  20,  68},
-                            {128, 160, 216, 152, 124,  84,  76, 166}};
-#else
-     int    bayer[4][4] = {{ 16, 143,  47, 175},
-                           {207,  79, 239, 111},
-                           { 63, 191,  31, 159},
-                           {255, 127, 223,  95}};
-#endif  
-    //holds the first address of the image
-    temp = out->pgm;
-    for(i = 0 ; i < height ; i++){
-        for(j = 0 ; j < width ; ){
-            for(n = 128, pbm = 0 ; j < width && n > 0 ;  j++, n >>=1){
-                oldPxl = src->pbm + j + i * width;
-                //masks old pixel to its corresponding bayer mask
-                pbm = (*oldPxl <= bayer[i % 4][j % 4])? pbm | n : pbm;  
-            }
-            //writes the 8 pixels (1 byte)
-            memcpy(out->pbm++, &pbm, sizeof(PBM));
-        }
-    }
-    //gets the first address of the image
-    out->pbm = temp;
-    
-}
-
-/*
- *=================================================================================
- *
- * void flipHorizontal(fileType *, fileFormat *, int ,int );
- * 
- * Description:
- *   flips the image horizontally
- *                                    
- *=================================================================================
- */
-void flipHorizontal(fileType *out, fileFormat *src, int width, int height)
-{
-    int          i;
-    int          j;
-    fileFormat   temp;
-    
-    //holds the first address of the image
-    temp.ppm = out->format.ppm;
-    for(i=0; i < height; i++){
-        for(j = width-1; j>=0;j--){
-            memcpy(out->format.ppm, src->ppm + j + i*width,sizeof(PPM));
-            out->format.ppm++;
-        }
-    }
-    //gets the first address of the image
-    out->format.ppm = temp.ppm;
-    
-}
-
-/*
- *=================================================================================
- *
- * void flipVertical(fileType *, fileFormat *, int ,int )
- * 
- * Description:
- *   flips the image vertically
- *                                    
- *=================================================================================
- */
-void flipVertical(fileType *out, fileFormat *src,  int width, int height)
-{
-    int          i;
-    int          j;
-    fileFormat   temp;
-
-    //holds the first address of the image
-    temp.ppm = out->format.ppm;
-    for(i = height - 1; i >= 0; i--){
-        for(j = 0; j < width; j++){
-            memcpy(out->format.ppm, src->ppm + j + i*width, sizeof(PPM));
-            out->format.ppm++;
-        }
-    }
-    //gets the first address of the image
-    out->format.ppm = temp.ppm;
-    
-}
-
-/*
- *=================================================================================
- *
- * void options()
- * 
- * Description:
- *   displays usage of the program
- *                                    
- *=================================================================================
- */
-void options()
-{
-    printf("\nUsage: ppmx [options] (filename.ppm)");
-    printf("\nOptions:\n-fv\t\tFlip vertically");
-    printf("\n-fh\t\tFlip horizontally");
-    printf("\n-w<width>\tScale to the new width (0 - 9999)");
-    printf("\n-r<angle>\tRotate CW (0 - 359)\n-mono\t\tConvert to bilevel (.pbm)format");
-    printf("\n-gray\t\tConvert to grayscale (.pgm) format\n");
-}
-
+/******************************************************************************************
+ *                                                                                        *
+ *                   Mid Year Programming Contest: Image Data Processing                  *
+ *                 Kyocera Document Solutions Development Philippines, Inc.               *
+ *                                                                                        *
+ ******************************************************************************************/
+
+/*
+ *=========================================================================================
+ *                                     Description
+ *-----------------------------------------------------------------------------------------
+ *  This program performs the basic image processing techniques but can only read a     
+ *  P6 PPM image format. This can do rescale with respect to aspect     
+ *  ratio, image rotation, P6 PPM to P5 PGM (grayscale) and P6 PPM to P4 PBM (bilevel)  
+ *  conversion, and image flip (vertically and horizontally).                           
+ *                                                                                      
+ *  For PPM information: http://netpbm.sourceforge.net/doc/ppm.html
+ *-----------------------------------------------------------------------------------------
+ *                                   Revision History
+ *----------+---------------------------+--------------------------------------------------
+ * 08/08/18 |   Philogene Kyle Dimpas   |   Updated the documentation style and added
+ *          |                           |   comment #Philogene Kyle Dimpas in the header
+ *----------+---------------------------+--------------------------------------------------
+ * 07/27/18 |   Philogene Kyle Dimpas   |   Finished the Program 
+ *=========================================================================================
+*/
+
+//=========================================================================================
+//                                     Definitions                       
+//=========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <limits.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#endif
+
+#define PXL unsigned char
+#define PGM unsigned char
+#define PBM unsigned char
+#define M_PI 3.14159265358979323846
+#define SHEAR_MIN_PIXELS 4000000    //-r switches to the 3-shear engine from this size
+#define FRAME_WINDOW     16         //frames in flight between the reader and the writer
+#define BOX_PASSES       3          //box blurs in a row to get close to a gaussian
+#define BOX_TILE         512        //bytes of every row one vertical blur tile covers
+#define SHARPEN_STRIP    256        //rows -sharpen and -usm blur at a time, plus the halo
+#define LOAD_CHUNK       (1 << 20)  //bytes readFrame() reads and counts for --stats at a time
+#define ROT_TILE         64         //output pixels per side of a rotation tile
+#define MAP_SLOTS        64         //mapped rasters alive at the same time
+#define WATCH_SEEN       131072     //slots of the files --watch remembers to skip retries
+
+#define EXIT(...)                                        \
+{   fprintf(stderr, ""__VA_ARGS__);                      \
+    if(fpIn != NULL && fpIn != stdin) fclose(fpIn);      \
+    if(fpOut != NULL && fpOut != stdout) fclose(fpOut);  \
+    for(i = 0 ; i < 3 ; i++)                             \
+        if(fpFan[i] != NULL && fpFan[i] != stdout)       \
+            fclose(fpFan[i]);                            \
+    for(i = 0 ; i < FRAME_WINDOW ; i++){                 \
+        rasterFree(frames[i].img.format.ppm);            \
+        rasterFree(frames[i].gray.format.ppm);           \
+        rasterFree(frames[i].mono.format.ppm);           \
+    }                                                    \
+    return exitCode;                                     \
+}
+
+typedef struct{
+    PXL  R;
+    PXL  G;
+    PXL  B;
+}PPM;
+
+typedef union{
+    PPM *ppm;
+    PGM *pgm;
+    PBM *pbm;
+}fileFormat;
+
+typedef struct{
+    fileFormat format;
+    size_t size;
+}fileType;
+
+typedef struct{
+    unsigned long long  hist[256];      //luma histogram, filled by toGrayScale() or while readFrame() loads
+    unsigned long long  count;
+    int                 min;
+    int                 max;
+    double              mean;
+    int                 low;            //0.5% and 99.5% points, the -mono auto-level range
+    int                 high;
+    int                 threshold;      //Otsu threshold, the middle of the --adaptive dither
+}lumaStats;
+
+typedef struct{
+    fileType   img;
+    fileType   gray;        //--out-pgm/--out-pbm renditions of img
+    fileType   mono;
+    int        info[3];     //headerInfo of the frame
+    char       type;        //fType[1] of the frame
+    lumaStats  luma;        //--stats of the frame
+    int        status;      //0 = free, 1 = processing, 2 = done, -1 = failed
+}frameSlot;
+
+typedef struct{
+    void      *addr;
+    size_t     length;
+}mappedRaster;
+
+typedef struct{
+    unsigned long long name;    //hash of the name, 0 = free slot
+    long long  size;
+    long long  mtime;           //nanoseconds
+}watchKey;
+
+typedef struct{
+    int        queued;      //files handed to the workers
+    int        done;
+    int        failed;
+    int        duplicates;  //retries of files already taken
+    int        maxDepth;
+    double     totalMs;     //from the event to the written output
+    double     maxMs;
+}watchStats;
+
+//=========================================================================================
+//                                     Global Variables                  
+//=========================================================================================
+int  headerInfo[3]; 
+char fType[2];
+char rotEngine = 'a';   //-r engine: a = auto, b = bilinear, s = shear, c = shear + compare
+int  inPlace   = 0;     //1 = --inplace, every option runs on a single raster when it can
+FILE *fpLog;            //messages go to stderr when the image goes to stdout
+FILE *fpFan[3];         //--out-ppm, --out-pgm and --out-pbm outputs
+char *fanPath[3];
+char *outPath  = NULL;  //-o <path>, "-" is stdout
+char *watchDir = NULL;  //--watch <dir>
+int  statsMode = 0;     //1 = --stats, prints the luma statistics of every frame
+int  adaptive  = 0;     //1 = --adaptive, -mono levels the gray and dithers around its threshold
+int  lumaAtLoad = 0;    //1 = --stats of color output, readFrame() counts the frame while it loads
+lumaStats luma;         //statistics of the frame this thread works on
+#ifdef __linux__
+volatile sig_atomic_t watchSignal = 0;  //SIGINT/SIGTERM stop --watch, SIGUSR1 prints the counters
+int  watchTemp = 0;     //numbers the --watch temp outputs
+#endif
+unsigned long long mapFrom = 0;     //rasters from this size live in mapped temp files, 0 = never
+mappedRaster mapped[MAP_SLOTS];
+#ifdef PPMX_VERIFY
+int  verifySeed = -1;   //--verify[seed] runs the kernel checks instead of an image
+#endif
+
+//every thread works on its own frame
+#pragma omp threadprivate(headerInfo, fType, luma)
+
+//=========================================================================================
+//                                   Function Prototypes                     
+//=========================================================================================
+
+int    allocMem(fileType *);
+void  *rasterAlloc(size_t);
+void  *rasterRealloc(void *, size_t);
+void   rasterFree(void *);
+int    readFrame(FILE *, fileType *);
+int    readFrameHeader(FILE *);
+int    moreFrames(FILE *);
+int    processFrame(fileType *, int, int *, int *);
+int    streamFrame(FILE *, FILE **, char [], int, int *, int *);
+void   runFrame(frameSlot *, int, int *, int *);
+int    fanOutFrame(frameSlot *);
+int    writeFrames(frameSlot *, int *, int, int, FILE **, char []);
+int    writeFanOut(frameSlot *);
+int    watchFolder(char [], char [], int, int *, int *);
+int    watchFile(char [], char [], double, watchStats *, int, int *, int *);
+int    watchSeen(watchKey *, char [], long long, long long);
+void   watchQueue(char [], char [], watchKey *, watchStats *, int, char [], int, int *, int *);
+void   watchReport(watchStats *);
+double watchClock();
+void   watchHandler(int);
+FILE  *openOutput(char []);
+char  *outputName(char []);
+int    writeImage(FILE *, fileType);
+int    writeHeader(FILE *);
+int    parseOptions(char [], int *);
+int    parseGlobals(int, char *[]);
+int    sortOptions(int, int*, char *[]);
+int    processInPlace(fileType *, int, int);
+int    convolve(fileType *, int, int);
+int    boxBlur(PXL *, int *, int, int, int);
+void   boxRadii(int, int *);
+void   boxRow(PXL *, PXL *, int, int, int, unsigned int);
+void   boxColumns(PXL *, int, int, int, int, int, unsigned int, PXL *, unsigned int *);
+int    rescaleWidth(fileType *, fileFormat *, int, int, int );
+int    scaledHeight(int, int, int);
+void   rescaleRow(PPM *, PPM *, PPM *, int, int, float, int );
+int    rotateImage(fileType *, fileFormat *, int, int, int );
+int    rotateAuto(fileType *, fileFormat *, int, int, int );
+int    rotateShear(fileType *, fileFormat *, int, int, int );
+int    compareRotation(fileType *, fileFormat *, int, int, int );
+void   shearRow(PPM *, int, PPM *, int, double );
+void   flipHorizontal(fileType *, fileFormat *, int ,int );
+void   flipVertical(fileType *, fileFormat *,  int ,int );
+void   toGrayScale(fileFormat *, fileFormat *, int ,int );
+void   dithering(fileFormat *, fileFormat *, int , int );
+void   ditherRow(PBM *, PGM *, int , int , PGM *);
+void   lumaHistogram(fileFormat *, int , int );
+void   lumaFinish(lumaStats *);
+void   lumaTable(PGM *);
+void   lumaReport(lumaStats *);
+void   rotate90(fileType *, fileFormat *, int , int );
+void   quarterTurn(PPM *, PPM *, int, int , int );
+void   flipHorizontalInPlace(fileFormat *, int , int );
+void   flipVerticalInPlace(fileFormat *, int , int );
+void   rotate180InPlace(fileFormat *, int , int );
+int    transposeInPlace(fileFormat *, int , int );
+unsigned long long availMem();
+#ifdef PPMX_VERIFY
+int    verifyKernels(unsigned int);
+int    verifySize(int, int);
+int    verifyCompare(char [], int, int, PBM *, PBM *, size_t, size_t);
+int    verifyInterior(char [], int, int, PPM *, PPM *, double);
+void   verifyFill(PPM *, int, int, int);
+void   verifyBoxBlur(PXL *, int *, int, int, int);
+void   verifyConvolve(PXL *, int, int, int, int, int);
+int    verifyRescale(fileType *, PPM *, int, int, int);
+int    verifyRotate(fileType *, PPM *, int, int, int);
+int    verifyDither(PBM *, PPM *, int, int, int);
+int    verifyStream(PPM *, int, int);
+#endif
+int    readHeader(FILE *);
+void   options();
+double round (double );
+
+//=========================================================================================
+//                                     Main Function                 
+//=========================================================================================
+int main(int argc, char *argv[])
+{   
+    frameSlot    frames[FRAME_WINDOW];
+    frameSlot   *slot;
+    FILE        *fpIn     = NULL;
+    FILE        *fpOut    = NULL;
+    char        *filename = NULL;
+    int          optionIdx[10];
+    int          optionType[10];
+    int          optionParam[10];
+    int          i;
+    int          status;
+    int          nRead    = 0;
+    int          nWritten = 0;
+#ifdef _OPENMP
+    int          nThreads = 1;      //frames become tasks only with a team to run them
+#endif
+    int          stream   = 0;
+    int          exitCode = EXIT_FAILURE;
+
+    fpLog = stdout;
+    memset(frames, 0, sizeof(frames));
+
+    argc = parseGlobals(argc, argv);
+#ifdef PPMX_VERIFY
+    if(verifySeed >= 0){
+        return verifyKernels(verifySeed)? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+#endif
+    //--out-* outputs are enough on their own, plain runs need an -option
+    if(argc < 3 && !(argc == 2 && (fanPath[0] || fanPath[1] || fanPath[2]))){
+        options();
+        exit(1);
+    }
+    if(outPath != NULL && (fanPath[0] || fanPath[1] || fanPath[2])){
+        EXIT("ERROR: conflict options (-o and --out-*)");
+    }
+    //a stdin image goes to stdout unless -o says otherwise
+    if(outPath == NULL && strcmp(argv[argc-1], "-") == 0 && !(fanPath[0] || fanPath[1] || fanPath[2])){
+        outPath = argv[argc-1];
+    }
+    //"-" keeps stdout for the image
+    if(outPath != NULL && strcmp(outPath, "-") == 0){
+        fpLog = stderr;
+    }
+    for(i = 0, status = 0 ; i < 3 ; i++){
+        if(fanPath[i] != NULL && strcmp(fanPath[i], "-") == 0){
+            fpLog = stderr;
+            status++;
+        }
+    }
+    //the renditions are written at the same time, they would interleave on stdout
+    if(status > 1){
+        EXIT("ERROR: only one --out-* can be -");
+    }
+    
+    if(argc > 2 && (i = sortOptions(argc, optionIdx, argv)) == 0){
+        EXIT();
+    }else if(argc > 2 && i == -1){
+        options();
+        EXIT("ERROR: -options invalid");
+        
+    }
+    //parse once so that the frame tasks only read the options
+    lumaAtLoad = statsMode && !fanPath[1] && !fanPath[2];
+    for(i=0 ; i < argc-2 ; i++){
+        optionType[i] = parseOptions(argv[optionIdx[i]], &optionParam[i]);
+        if(optionType[i] < 1 || optionType[i] > 9){
+            options();
+            EXIT();
+        }
+        if((optionType[i] == 5 || optionType[i] == 6) && (fanPath[0] || fanPath[1] || fanPath[2])){
+            EXIT("ERROR: conflict options (%s and --out-*)", argv[optionIdx[i]]);
+        }
+        //gray output is counted by toGrayScale() instead
+        if(optionType[i] == 5 || optionType[i] == 6){
+            lumaAtLoad = 0;
+        }
+    }
+
+    //rasters over half of the available memory go to temp files the system can page out
+    if(mapFrom == 0){
+        mapFrom = availMem() / 2;
+    }
+
+    //--watch runs the options on every file dropped into the folder until it is stopped
+    if(watchDir != NULL){
+        if(outPath == NULL || fanPath[0] || fanPath[1] || fanPath[2]){
+            EXIT("ERROR: --watch needs -o <folder> and no --out-*");
+        }
+        exitCode = watchFolder(watchDir, outPath, argc-2, optionType, optionParam)? EXIT_SUCCESS : EXIT_FAILURE;
+        EXIT();
+    }
+
+    //the renditions share the decode and the options, only the files differ
+    for(i = 0 ; i < 3 ; i++){
+        if(fanPath[i] != NULL){
+            fpFan[i] = (strcmp(fanPath[i], "-") == 0)? stdout : fopen(fanPath[i], "wb");
+            if(fpFan[i] == NULL){
+                EXIT("ERROR: cannot create %s", fanPath[i]);
+            }
+        }
+    }
+
+    filename = argv[argc-1];
+    //"-" reads the frames from stdin
+    if(strcmp(filename, "-") == 0){
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        fpIn  = stdin;
+    }else{
+        fpIn = fopen(filename,"rb");
+    }
+
+    if(fpIn == NULL){
+        EXIT("ERROR: File not found");
+    }
+
+    //a chain of row-local options on stdin runs row by row, see streamFrame()
+    stream = (fpIn == stdin && !(fanPath[0] || fanPath[1] || fanPath[2]));
+    for(i = 0 ; i < argc-2 ; i++){
+        stream = stream && (optionType[i] == 2 || optionType[i] == 3 || (optionType[i] == 5 && !adaptive) ||
+                            optionType[i] == 6);
+    }
+
+    status = stream? readFrameHeader(fpIn) : readFrame(fpIn, &frames[0].img);
+    if(status == 0){
+        EXIT("ERROR: File not PPM P6 format");
+    }else if(status == -1){
+        EXIT();
+    }
+
+    //streamed frames are written before the next one is read, the loop below
+    //only gets the frames that are not streamed
+    while(stream && status == 1){
+        if(!streamFrame(fpIn, &fpOut, filename, argc-2, optionType, optionParam)){
+            status = -1;
+            break;
+        }
+        if(statsMode){
+            lumaReport(&luma);
+        }
+        nRead++;
+        nWritten++;
+        status = readFrameHeader(fpIn);
+    }
+
+    //the thread running the reader below may not be this one
+    memcpy(frames[0].info, headerInfo, sizeof(headerInfo));
+    frames[0].type = fType[1];
+    frames[0].luma = luma;
+
+    //a source and an output copy would not fit, so work on one raster
+    if(!inPlace && !stream && availMem() != 0 && availMem() < 3ULL * frames[0].img.size){
+        inPlace = 1;
+    }
+
+#ifdef _WIN32
+    for(i = 0 ; i < 3 ; i++){
+        if(fpFan[i] == stdout) _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+
+    //a single image keeps all threads for its own loops, a stream spreads the
+    //frames over the threads and writes them back in order
+    #pragma omp parallel private(slot, i) if(!stream && moreFrames(fpIn))
+    #pragma omp single
+    {
+#ifdef _OPENMP
+        nThreads = omp_get_num_threads();
+#endif
+        while(status == 1){
+            slot = frames + nRead % FRAME_WINDOW;
+            //the first frame is in frames[0] already
+            if(nRead > 0){
+                if((status = readFrame(fpIn, &slot->img)) != 1){
+                    break;
+                }
+                memcpy(slot->info, headerInfo, sizeof(headerInfo));
+                slot->type = fType[1];
+                slot->luma = luma;
+            }
+            slot->status = 1;
+            nRead++;
+
+            //with one thread the frame runs right here, nobody else would take it
+            #pragma omp task firstprivate(slot) depend(out: slot->status) if(nThreads > 1)
+            runFrame(slot, argc-2, optionType, optionParam);
+
+            //the oldest frame has to leave the reorder buffer before its slot is reused
+            i = (nRead - nWritten == FRAME_WINDOW)? nWritten + 1 : nWritten;
+            if(!writeFrames(frames, &nWritten, nRead, i, &fpOut, filename)){
+                status = -1;
+            }
+        }
+        if(status == 0 && !writeFrames(frames, &nWritten, nRead, nRead, &fpOut, filename)){
+            status = -1;
+        }
+    }
+
+    if(status == -1){
+        EXIT("\nERROR: stopped after %d frame(s)\n", nWritten);
+    }
+
+    //a full disk may only show when the rest of the buffer goes out
+    status = 1;
+    if(fpOut != NULL){
+        status = ((fpOut == stdout)? fflush(fpOut) : fclose(fpOut)) == 0;
+        fpOut = NULL;
+    }
+    for(i = 0 ; i < 3 ; i++){
+        if(fpFan[i] != NULL){
+            status = ((fpFan[i] == stdout)? fflush(fpFan[i]) : fclose(fpFan[i])) == 0 && status;
+            fpFan[i] = NULL;
+        }
+    }
+    if(!status){
+        EXIT("\nERROR: Unable to write into the file\n");
+    }
+
+    for(i=0 ; i < argc-2 ; i++){
+        fprintf(fpLog, "%s ", argv[optionIdx[i]]);
+    }
+    if(nRead > 1){
+        fprintf(fpLog, "(%d frames) ", nRead);
+    }
+    exitCode = EXIT_SUCCESS;
+    EXIT("done!");
+    return 0;
+}
+
+
+
+//=========================================================================================
+//                                      Functions                
+//=========================================================================================
+
+
+/*
+ *=================================================================================
+ *
+ *  int parseOptions(char [], int* )
+ * 
+ *  Description:
+ *   Parses the given string option.
+ *  Return: 
+ *   This will return an integer based on its corresponding type; otherwise its 0.                    
+ *
+ *=================================================================================
+ */
+int parseOptions(char option[], int *param)
+{
+    int i;
+    int j;
+    int type = -1;
+    int newWidth = 0;
+    char buff[10];
+    
+    for(i = 1 ; option[i] != '\0' && type ; i++){
+
+        switch(option[i]){
+            //-fv is type 1 and -fh is 2        
+            case 'f':
+
+                if((option[++i] == 'v' || option[i] == 'h') && option[i+1] == '\0'){
+                    type = (option[i] == 'v')? 1: 2;
+                }
+                break;
+            //-w is type 3 and -r is 4
+            case 'w': 
+            case 'r':
+                //-rb, -rs and -rc pick the rotate engine
+                if(option[i] == 'r' && (option[i+1] == 'b' || option[i+1] == 's' || option[i+1] == 'c')){
+                    rotEngine = option[++i];
+                }
+                //limits number to 9 digits only
+                for(j=0, ++i ; j < 9 && option[i] != '\0' && isdigit(option[i]) ; j++, i++){
+                    buff[j] = option[i];
+                }
+                buff[j] = '\0';
+
+                if(option[i] == '\0' && j != 0){
+                    *param = atoi(buff);
+                    type = (option[1] == 'w')?3:4;
+                }else{
+                    fprintf(fpLog, "ERROR: invalid input");
+                    type = 0;
+                }
+                //check if width is greater than 0
+                
+                type = (type == 3 && *param < 1 )? 0: type;
+                type = (type == 4 && *param > 359)? 0: type;
+
+                i = strlen(option) - 1;
+                break;
+            //-blur is type 7, -sharpen is 8 and -usm is 9
+            case 'b':
+            case 's':
+            case 'u':
+                type = (strncmp(option, "-blur", 5) == 0)? 7 : (strncmp(option, "-sharpen", 8) == 0)? 8 :
+                       (strncmp(option, "-usm", 4) == 0)? 9 : 0;
+                //limits numbers to 3 digits only
+                for(i = j = (type == 7)? 5 : (type == 8)? 8 : 4 ; type && isdigit(option[i]) && i - j < 3 ; i++);
+                *param = (i > j)? atoi(option + j) : -1;
+                //-usm<radius>,<amount> keeps radius * 1000 + amount, the amount defaults to 100
+                if(type == 9 && *param > 0){
+                    *param *= 1000;
+                    if(option[i] == ','){
+                        for(j = ++i ; isdigit(option[i]) && i - j < 3 ; i++);
+                        *param = (i > j)? *param + atoi(option + j) : -1;
+                    }else{
+                        *param += 100;
+                    }
+                }
+                if(type == 0 || option[i] != '\0' || *param < ((type == 8)? 0 : 1)){
+                    fprintf(fpLog, "ERROR: invalid input");
+                    type = 0;
+                }
+
+                i = strlen(option) - 1;
+                break;
+            //-mono is type 5 and -gray is 6
+            case 'm': 
+            case 'g': 
+            
+                if(strcmp(option,"-mono") == 0){
+                    type = 5;
+                }else if(strcmp(option,"-gray") == 0){
+                    type = 6;
+                }
+            
+                i = strlen(option)-1;
+                break;
+            
+            default : type = 0;  break;
+        }
+    }
+
+    return type;
+
+}
+/*
+ *=================================================================================
+ *
+ *  int sortOptions(int , int *, char *[])
+ * 
+ *  Description:
+ *    Sorts the options according to it's heirarchy.
+ *    heirarchy of -options: -blur -sharpen -usm -w (-r -f) -gray -mono.
+ *    (-r & -f are in same heirarchy)          
+ *  Return:
+ *    returns 1 if successful; else 0.                    
+ *
+ *=================================================================================
+ */
+int sortOptions(int size, int *options, char *argv[])
+{
+    
+    unsigned int    optionSet = 0;  //1024 = b, 512 = s, 256 = u, 128 = w, 64 = r, 32 = f, 16 = g, 8 = m,
+                                    //1 = flag swap f and r
+    char            str[100];
+    int             i;
+    int             idx;
+    int             cnt;
+    int             mask = 1024;
+    int             invalidFlag = 0;
+    char            prioOptions[9] = {'b', 's', 'u', 'w', 'r', 'f', 'g', 'm'};
+    
+    for(cnt = i = 0 ; i < 9 && cnt < size - 2 ; i ++, mask >>= 1){
+
+        for(idx = 1 ; idx < size - 1; idx++){
+            if(*argv[idx] != '-'){
+                fprintf(fpLog, "ERROR: -options invalid");
+                return 0;
+            }
+            if(*(argv[idx] + 1) == prioOptions[i]){
+                //check if the -option is not yet in the set
+                if((optionSet & mask) == mask){
+                    fprintf(fpLog, "ERROR: duplicate options");
+                    return 0;
+                }
+                if(i == 7 && (optionSet & 16) == 16){
+                    fprintf(fpLog, "ERROR: conflict options (mono and gray)");
+                    return 0;
+                }
+
+                options[cnt++] = idx;
+                optionSet |= mask;
+                //ideally rotate and flip can be exchanged but rotate is always be first
+                //this condition will swap flip over rotate if flip was inputted first by the user
+                if( (optionSet & 96) == 96 && (optionSet & 1) != 1){
+                    if(idx < options[cnt - 2]){
+                        options[cnt-2] = options[cnt-2] + options[cnt-1];
+                        options[cnt-1] = options[cnt-2] - options[cnt-1];
+                        options[cnt-2] = options[cnt-2] - options[cnt-1];
+                    }
+                    //check only once
+                    optionSet |= 1;
+                }
+            }
+        }
+
+    }
+    
+    return (cnt > 0 && cnt == size-2)? 1 : -1;  
+}
+
+/*
+ *=================================================================================
+ *
+ *  int parseGlobals(int , char *[])
+ * 
+ *  Description:
+ *    Takes out the --options that change how ppmx runs rather than the image
+ *    (--inplace, --mapped, --stats, --adaptive, --out-ppm/pgm/pbm <path>, -o <path>,
+ *    --watch <dir>) so that sortOptions() only sees image -options.
+ *  Return:
+ *    returns the new argument count; 0 if an --option misses its value.
+ *
+ *=================================================================================
+ */
+int parseGlobals(int argc, char *argv[])
+{
+    int     i;
+    int     cnt;
+
+    for(cnt = i = 1 ; i < argc ; i++){
+        if(strcmp(argv[i], "--inplace") == 0){
+            inPlace = 1;
+        }else if(strcmp(argv[i], "--mapped") == 0){
+            mapFrom = 1;
+        }else if(strcmp(argv[i], "--stats") == 0){
+            statsMode = 1;
+        }else if(strcmp(argv[i], "--adaptive") == 0){
+            adaptive = 1;
+        }else if(strcmp(argv[i], "--out-ppm") == 0 || strcmp(argv[i], "--out-pgm") == 0 ||
+                 strcmp(argv[i], "--out-pbm") == 0){
+            if(i + 1 == argc){
+                return 0;
+            }
+            fanPath[(argv[i][7] == 'p')? 0 : (argv[i][7] == 'g')? 1 : 2] = argv[i + 1];
+            i++;
+        }else if(strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--watch") == 0){
+            if(i + 1 == argc){
+                return 0;
+            }
+            if(argv[i][1] == 'o'){
+                outPath = argv[i + 1];
+            }else{
+                watchDir = argv[i + 1];
+            }
+            i++;
+#ifdef PPMX_VERIFY
+        }else if(strncmp(argv[i], "--verify", 8) == 0){
+            verifySeed = atoi(argv[i] + 8);
+#endif
+        }else{
+            argv[cnt++] = argv[i];
+        }
+    }
+    //the folder takes the place of the file name
+    if(watchDir != NULL){
+        argv[cnt++] = watchDir;
+    }
+    argv[cnt] = NULL;
+
+    return cnt;
+}
+
+/*
+ *=================================================================================
+ *
+ * int readFrame(FILE *, fileType *)
+ * 
+ * Description:
+ *   Reads the next P6 frame of the stream. A file can hold several frames
+ *   one after the other (netpbm allows it), whitespace in between is skipped.
+ *   The frame's luma statistics start over; with lumaAtLoad the frame is read
+ *   in chunks of whole rows and every chunk is counted while it is in cache.
+ * Return:
+ *  returns 1 if a frame was read, 0 if the stream has no more frames; else -1
+ *
+ *=================================================================================
+ */
+int readFrame(FILE *fp, fileType *img)
+{
+    int         status;
+    int         rows;
+    size_t      rowSize;
+    size_t      done;
+    size_t      part;
+    fileFormat  chunk;
+
+    if((status = readFrameHeader(fp)) != 1){
+        return status;
+    }
+
+    memset(&luma, 0, sizeof(luma));
+    img->format.ppm = NULL;
+    if(!allocMem(img)){
+        fprintf(stderr, "ERROR: Source image cannot allocate memory");
+        return -1;
+    }
+
+    rowSize = sizeof(PPM) * (size_t) headerInfo[0];
+    rows = (rowSize == 0 || rowSize >= LOAD_CHUNK)? 1 : (int) (LOAD_CHUNK / rowSize);
+    part = lumaAtLoad? rows * rowSize : img->size;
+    for(done = 0 ; done < img->size ; done += part){
+        if(part > img->size - done){
+            part = img->size - done;
+        }
+        if(fread((char*) img->format.ppm + done, 1, part, fp) != part){
+            fprintf(stderr, "ERROR: fread cannot read source image");
+            return -1;
+        }
+        if(lumaAtLoad){
+            chunk.ppm = (PPM*) ((char*) img->format.ppm + done);
+            lumaHistogram(&chunk, headerInfo[0], (int) (part / rowSize));
+        }
+    }
+    return 1;
+}
+
+//=================================================================================
+// Function readFrameHeader() reads the magic number and the header of the next
+// frame into fType and headerInfo. Returns 1, 0 at the end of the stream; else -1.
+//=================================================================================
+int readFrameHeader(FILE *fp)
+{
+    int     ch;
+
+    while((ch = fgetc(fp)) != EOF && isspace(ch));
+    if(ch == EOF){
+        return 0;
+    }
+
+    fType[0] = ch;
+    fType[1] = fgetc(fp);
+    if('P' != fType[0] || '6' != fType[1]){
+        fprintf(stderr, "ERROR: File not PPM P6 format");
+        return -1;
+    }
+    if(!readHeader(fp)){
+        fprintf(stderr, "ERROR: incomplete header");
+        return -1;
+    }
+    return 1;
+}
+
+//=================================================================================
+// Function moreFrames() checks if another frame follows without consuming it.
+//=================================================================================
+int moreFrames(FILE *fp)
+{
+    int     ch;
+
+    while((ch = fgetc(fp)) != EOF && isspace(ch));
+    if(ch == EOF){
+        return 0;
+    }
+    ungetc(ch, fp);
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int processFrame(fileType *, int, int *, int *)
+ * 
+ * Description:
+ *   Runs the sorted options on one frame. The result replaces img and
+ *   headerInfo/fType describe it afterwards.
+ * Return:
+ *  returns 1 if successful; else 0
+ *
+ *=================================================================================
+ */
+int processFrame(fileType *img, int cnt, int type[], int param[])
+{
+    fileType     outImg;
+    int          i;
+
+    outImg.format.ppm = NULL;
+    outImg.size = 0;
+
+    if(!inPlace && !allocMem(&outImg)){
+        fprintf(stderr, "ERROR: Cannot create new file");
+        return 0;
+    }
+
+    //planning to revise and remove the switch
+    for(i=0 ; i < cnt ; i++){
+        //the filters work inside img with a few rows of their own
+        if(type[i] >= 7){
+            if(!convolve(img, type[i], param[i])){
+                fprintf(stderr, "ERROR: failed to allocate memory for the filter");
+                rasterFree(outImg.format.ppm);
+                return 0;
+            }
+            continue;
+        }
+        if(inPlace){
+            if(!processInPlace(img, type[i], param[i])){
+                fprintf(stderr, "ERROR: failed to allocate memory for option %d", i + 1);
+                return 0;
+            }
+            continue;
+        }
+        switch (type[i]){
+            case 1:
+                flipVertical(&outImg, &img->format, headerInfo[0], headerInfo[1]); break;
+            case 2:
+                flipHorizontal(&outImg, &img->format, headerInfo[0], headerInfo[1]); break;
+            case 3:
+                if(!rescaleWidth(&outImg, &img->format, param[i], headerInfo[0], headerInfo[1])){
+                    fprintf(stderr, "ERROR: failed to allocate memory for the scaled image");
+                    rasterFree(outImg.format.ppm);
+                    return 0;
+                }
+                break;
+            case 4:
+                if(!rotateAuto(&outImg, &img->format, param[i], headerInfo[0], headerInfo[1])){
+                    fprintf(stderr, "ERROR: failed to allocate memory for rotate image");
+                    rasterFree(outImg.format.ppm);
+                    return 0;
+                }
+                break;
+            case 5:
+                //the gray goes to outImg over all threads and is dithered there, row by row
+                fType[1] = '5';
+                allocMem(&outImg);
+                toGrayScale(&outImg.format, &img->format, headerInfo[0], headerInfo[1]);
+                fType[1] = '4';
+                dithering(&outImg.format, &outImg.format, headerInfo[0], headerInfo[1]);
+                allocMem(&outImg);
+                break;
+            case 6: 
+                fType[1] = '5';
+                allocMem(&outImg);
+                toGrayScale(&outImg.format, &img->format, headerInfo[0], headerInfo[1]);
+                break;
+        }
+
+        if(fType[1] == '6'){
+            rasterFree(img->format.ppm);
+        }
+        
+        if(!allocMem(img)){
+            fprintf(stderr, "ERROR: Failed to allocate memory for output copy");
+            rasterFree(outImg.format.ppm);
+            return 0;
+        }
+
+        memcpy(img->format.ppm, outImg.format.ppm, outImg.size);
+    }
+
+    rasterFree(outImg.format.ppm);
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int streamFrame(FILE *, FILE **, char [], int, int *, int *)
+ * 
+ * Description:
+ *   Runs a chain of row-local options (-w, -fh, -gray, -mono) on the frame whose
+ *   header was just read, one row at a time. Every output row is written as soon
+ *   as the source rows it needs have come in, so a pipe gets the first rows
+ *   while the rest is still on its way. Two source rows and one output row are
+ *   all the memory it takes. The output is the same as processFrame()'s.
+ * Return:
+ *  returns 1 if successful; else 0
+ *
+ *=================================================================================
+ */
+int streamFrame(FILE *fpIn, FILE **fpOut, char srcName[], int cnt, int type[], int param[])
+{
+    int          width = headerInfo[0];
+    int          height = headerInfo[1];
+    int          newWidth = width;
+    int          newHeight = height;
+    int          scale = 0;
+    int          flip = 0;
+    int          loaded = 0;        //source rows read so far
+    int          i;
+    int          y;
+    float        xRatio = 0;
+    float        yRatio = 0;
+    size_t       outSize;
+    char         outType = '6';
+    PPM         *rows;              //source rows y and y + 1, row k is in rows[k % 2]
+    fileFormat   line;              //output row, turned into gray and bilevel in place
+    fileFormat   source;            //the source row just read, for --stats
+    PGM          lut[256];
+
+    for(i = 0 ; i < cnt ; i++){
+        switch(type[i]){
+            case 2: flip = 1; break;
+            case 3: scale = 1;
+                    newWidth = param[i];
+                    if((newHeight = scaledHeight(width, height, newWidth)) == 0){
+                        return 0;
+                    }
+                    xRatio = ( (float) width - 1) / newWidth;
+                    yRatio = ( (float) height - 1) / newHeight;
+                    break;
+            case 5: outType = '4'; break;
+            case 6: outType = '5'; break;
+        }
+    }
+    outSize = (outType == '6')? sizeof(PPM) * newWidth : (outType == '5')? newWidth : (newWidth + 7) / 8;
+
+    rows = (PPM*)malloc(sizeof(PPM) * (2 * (size_t) width + 1));
+    line.ppm = (PPM*)malloc(sizeof(PPM) * ((size_t) newWidth + 1));
+    if(rows == NULL || line.ppm == NULL){
+        fprintf(stderr, "ERROR: Failed to allocate memory for the rows");
+        free(rows);
+        free(line.ppm);
+        return 0;
+    }
+
+    //--stats counts every row while it is in cache, --adaptive needs them all first so it does not stream
+    memset(&luma, 0, sizeof(luma));
+    lumaTable(lut);
+    headerInfo[0] = newWidth;
+    headerInfo[1] = newHeight;
+    fType[1] = outType;
+    if((*fpOut == NULL && (*fpOut = openOutput(srcName)) == NULL) || !writeHeader(*fpOut)){
+        free(rows);
+        free(line.ppm);
+        return 0;
+    }
+
+    for(i = 0 ; i < newHeight ; i++){
+        //reads up to the row below the one the output row starts from
+        y = scale? (int) (yRatio * i) : i;
+        for( ; loaded <= y + 1 && loaded < height ; loaded++){
+            if(fread(rows + (loaded % 2) * (size_t) width, sizeof(PPM), width, fpIn) != (size_t) width){
+                fprintf(stderr, "ERROR: fread cannot read source image");
+                free(rows);
+                free(line.ppm);
+                return 0;
+            }
+            if(lumaAtLoad){
+                source.ppm = rows + (loaded % 2) * (size_t) width;
+                lumaHistogram(&source, width, 1);
+            }
+        }
+
+        if(scale){
+            rescaleRow(line.ppm, rows + (y % 2) * (size_t) width,
+                       rows + (((y + 1 < height)? y + 1 : y) % 2) * (size_t) width,
+                       newWidth, width, xRatio, (int) ((yRatio * i) - y));
+        }else{
+            memcpy(line.ppm, rows + (y % 2) * (size_t) width, sizeof(PPM) * width);
+        }
+        if(flip){
+            flipHorizontalInPlace(&line, newWidth, 1);
+        }
+        if(outType != '6'){
+            toGrayScale(&line, &line, newWidth, 1);
+        }
+        if(outType == '4'){
+            ditherRow(line.pbm, line.pgm, newWidth, i, lut);
+        }
+
+        if(fwrite(line.ppm, 1, outSize, *fpOut) != outSize){
+            fprintf(fpLog, "ERROR: Unable to write into the file");
+            free(rows);
+            free(line.ppm);
+            return 0;
+        }
+    }
+
+    //a shrinking -w may not need the last source rows, they still have to leave the stream
+    for( ; loaded < height ; loaded++){
+        if(fread(rows, sizeof(PPM), width, fpIn) != (size_t) width){
+            fprintf(stderr, "ERROR: fread cannot read source image");
+            free(rows);
+            free(line.ppm);
+            return 0;
+        }
+        if(lumaAtLoad){
+            source.ppm = rows;
+            lumaHistogram(&source, width, 1);
+        }
+    }
+
+    free(rows);
+    free(line.ppm);
+    lumaFinish(&luma);
+    return fflush(*fpOut) == 0;
+}
+
+//=================================================================================
+// Function runFrame() is the task body of one frame: it loads the frame geometry
+// into this thread's headerInfo, processes it and hands it back to the writer.
+//=================================================================================
+void runFrame(frameSlot *slot, int cnt, int type[], int param[])
+{
+    int     status;
+
+    memcpy(headerInfo, slot->info, sizeof(headerInfo));
+    fType[0] = 'P';
+    fType[1] = slot->type;
+    luma = slot->luma;
+
+    status = processFrame(&slot->img, cnt, type, param)? 2 : -1;
+    if(status == 2 && !fanOutFrame(slot)){
+        status = -1;
+    }
+    if(status == 2 && statsMode){
+        lumaFinish(&luma);
+        slot->luma = luma;
+    }
+
+    memcpy(slot->info, headerInfo, sizeof(headerInfo));
+    slot->type = fType[1];
+    #pragma omp flush
+    #pragma omp atomic write
+    slot->status = status;
+}
+
+//=================================================================================
+// Function fanOutFrame() makes the --out-pgm and --out-pbm renditions of a
+// processed frame. The color image stays in img for --out-ppm.
+//=================================================================================
+int fanOutFrame(frameSlot *slot)
+{
+    if(fanPath[1] == NULL && fanPath[2] == NULL){
+        return 1;
+    }
+
+    fType[1] = '5';
+    slot->gray.format.ppm = NULL;
+    if(!allocMem(&slot->gray)){
+        return 0;
+    }
+    toGrayScale(&slot->gray.format, &slot->img.format, headerInfo[0], headerInfo[1]);
+
+    if(fanPath[2] != NULL){
+        fType[1] = '4';
+        slot->mono.format.ppm = NULL;
+        if(!allocMem(&slot->mono)){
+            return 0;
+        }
+        dithering(&slot->mono.format, &slot->gray.format, headerInfo[0], headerInfo[1]);
+    }
+    fType[1] = '6';
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int writeFrames(frameSlot *, int *, int, int, FILE **, char [])
+ * 
+ * Description:
+ *   Writes the finished frames in reading order, starting at *nWritten. Frames
+ *   before waitUntil are waited for, the rest only if they are done already.
+ *   The output is opened on the first frame since the extension depends on it.
+ * Return:
+ *  returns 1 if successful; else 0
+ *
+ *=================================================================================
+ */
+int writeFrames(frameSlot frames[], int *nWritten, int nRead, int waitUntil, FILE **fpOut, char srcName[])
+{
+    frameSlot   *slot;
+    int          status;
+
+    while(*nWritten < nRead){
+        slot = frames + *nWritten % FRAME_WINDOW;
+        #pragma omp atomic read
+        status = slot->status;
+
+        if(status == 1){
+            if(*nWritten >= waitUntil){
+                break;
+            }
+            //sleeps on the task of this frame (or runs queued frames) instead of spinning
+            #pragma omp taskwait depend(in: slot->status)
+            continue;
+        }
+        #pragma omp flush
+        if(status == -1){
+            return 0;
+        }
+
+        if(fanPath[0] || fanPath[1] || fanPath[2]){
+            if(!writeFanOut(slot)){
+                return 0;
+            }
+        }else{
+            memcpy(headerInfo, slot->info, sizeof(headerInfo));
+            fType[1] = slot->type;
+            if(*fpOut == NULL && (*fpOut = openOutput(srcName)) == NULL){
+                return 0;
+            }
+            if(!writeImage(*fpOut, slot->img) || fflush(*fpOut) != 0){
+                return 0;
+            }
+        }
+        if(statsMode){
+            lumaReport(&slot->luma);
+        }
+
+        rasterFree(slot->img.format.ppm);
+        rasterFree(slot->gray.format.ppm);
+        rasterFree(slot->mono.format.ppm);
+        slot->img.format.ppm = slot->gray.format.ppm = slot->mono.format.ppm = NULL;
+        slot->status = 0;
+        (*nWritten)++;
+    }
+    return 1;
+}
+
+//=================================================================================
+// Function writeFanOut() writes the renditions of one frame to their outputs at
+// the same time. With several frames it runs inside the frame pipeline, where the
+// loop is nested and the renditions go out one after another on this thread.
+//=================================================================================
+int writeFanOut(frameSlot *slot)
+{
+    int     i;
+    int     status = 1;
+
+    #pragma omp parallel for reduction(&&:status)
+    for(i = 0 ; i < 3 ; i++){
+        if(fpFan[i] == NULL){
+            continue;
+        }
+        //headerInfo and fType belong to the thread writing
+        memcpy(headerInfo, slot->info, sizeof(headerInfo));
+        fType[0] = 'P';
+        fType[1] = '6' - i;
+        status = writeImage(fpFan[i], (i == 0)? slot->img : (i == 1)? slot->gray : slot->mono) &&
+                 fflush(fpFan[i]) == 0 && status;
+    }
+    return status;
+}
+
+/*
+ *=================================================================================
+ *
+ * FILE *openOutput(char [])
+ * 
+ * Description:
+ *   Creates the output file given by -o ("-" is stdout), or else the one named
+ *   after the source and the final format
+ * Return:
+ *  returns the file if successful; else NULL
+ *
+ *=================================================================================
+ */
+FILE *openOutput(char srcName[])
+{
+    FILE    *fp;
+    char    *filename;
+
+    if(outPath != NULL && strcmp(outPath, "-") == 0){
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        return stdout;
+    }
+    if(outPath != NULL){
+        if((fp = fopen(outPath, "wb")) == NULL){
+            fprintf(fpLog, "ERROR: cannot create %s", outPath);
+        }
+        return fp;
+    }
+
+    filename = outputName(srcName);
+    fp = (filename != NULL)? fopen(filename,"wb") : NULL;
+    if(fp == NULL){
+        fprintf(fpLog, "ERROR: cannot create new file");
+    }
+    free(filename);
+    return fp;
+}
+
+//=================================================================================
+// Function outputName() names the output after the source and the final format:
+// the source without its .extension plus .ppm.out/.pgm.out/.pbm.out. The name is
+// malloc'd; NULL if there is no memory or no such format.
+//=================================================================================
+char *outputName(char srcName[])
+{
+    char    *filename;
+    size_t   len = strlen(srcName);
+
+    //copy filename without .extension
+    if((filename = (char*)malloc(len + 9)) == NULL){
+        return NULL;
+    }
+    len = (len > 4)? len - 4 : len;
+    memcpy(filename, srcName, len);
+    filename[len] = '\0';
+
+    switch(fType[1]){
+        case '6': strcat(filename,".ppm.out"); break;
+        case '5': strcat(filename,".pgm.out"); break;
+        case '4': strcat(filename,".pbm.out"); break;
+        default : free(filename);
+                  filename = NULL;
+                  break;
+    }
+    return filename;
+}
+
+/*
+ *=================================================================================
+ *
+ * int writeImage(FILE *, fileType)
+ * 
+ * Description:
+ *   Writes the header and the content of the memory as one frame
+ * Return:
+ *  returns 1 if successful; else 0                               
+ *
+ *=================================================================================
+ */
+int writeImage(FILE *fp, fileType out)
+{
+    if(!writeHeader(fp)){
+        return 0;
+    }
+    if(fwrite(out.format.ppm,1,out.size,fp) != out.size){
+        fprintf(fpLog, "ERROR: Unable to write into the file");
+        return 0;
+    }
+    return 1;
+}
+
+//=================================================================================
+// Function writeHeader() writes the header of a frame from fType and headerInfo.
+//=================================================================================
+int writeHeader(FILE *fp)
+{
+    //writes the header of the file
+    if(fprintf(fp,"P%c\n#Philogene Kyle Dimpas\n"
+        "%d %d\n",fType[1],headerInfo[0],headerInfo[1]) < 0){
+        fprintf(fpLog, "ERROR: Unable to write into the file");
+        return 0;
+    }
+    //writes maximum color value
+    if(fType[1] != '4'){
+        fprintf(fp,"%d\n", headerInfo[2]);
+    }
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int watchFolder(char [], char [], int, int *, int *)
+ * 
+ * Description:
+ *   --watch: waits with inotify for files that are closed after writing or moved
+ *   into dir and runs the options on each of them, the output goes to outDir
+ *   with the usual .ppm.out/.pgm.out/.pbm.out name. This thread only listens,
+ *   the files are OpenMP tasks for the other threads. A file that comes again
+ *   with the same name, size and time is a retry and is skipped. Hidden files
+ *   (half written copies) are left alone. Every file logs its latency and the
+ *   queue depth, SIGUSR1 prints the counters and SIGINT/SIGTERM stop it.
+ * Return:
+ *  returns 1 if it was stopped by a signal; else 0
+ *
+ *=================================================================================
+ */
+#ifdef __linux__
+int watchFolder(char dir[], char outDir[], int cnt, int type[], int param[])
+{
+    static watchKey       seen[WATCH_SEEN];
+    watchStats            stats;
+    struct stat           st;
+    struct inotify_event *event;
+    struct pollfd         pfd;
+    char                  buff[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    char                  inReal[PATH_MAX];
+    char                  outReal[PATH_MAX];
+    char                 *ptr;
+    DIR                  *folder;
+    struct dirent        *entry;
+    ssize_t               len;
+    int                   rescan = 1;
+    int                   nThreads = 1;
+
+    memset(&stats, 0, sizeof(stats));
+    //outputs are named after their files
+    outPath = NULL;
+
+    if(realpath(dir, inReal) == NULL || realpath(outDir, outReal) == NULL ||
+       stat(outReal, &st) != 0 || !S_ISDIR(st.st_mode)){
+        fprintf(stderr, "ERROR: cannot open %s or %s", dir, outDir);
+        return 0;
+    }
+    //the outputs would come back as new files
+    if(strcmp(inReal, outReal) == 0){
+        fprintf(stderr, "ERROR: the output folder has to differ from the watched one");
+        return 0;
+    }
+    pfd.fd = inotify_init1(IN_CLOEXEC);
+    pfd.events = POLLIN;
+    if(pfd.fd == -1 || inotify_add_watch(pfd.fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) == -1){
+        fprintf(stderr, "ERROR: cannot watch %s", dir);
+        return 0;
+    }
+    signal(SIGINT, watchHandler);
+    signal(SIGTERM, watchHandler);
+    signal(SIGUSR1, watchHandler);
+    fprintf(fpLog, "watching %s, writing to %s\n", dir, outDir);
+    fflush(fpLog);
+
+    #pragma omp parallel private(len, ptr, event, folder, entry)
+    #pragma omp single
+    {
+#ifdef _OPENMP
+        nThreads = omp_get_num_threads();
+#endif
+        //the timeout only checks the signals, any thread may have caught them
+        while(watchSignal != SIGINT && watchSignal != SIGTERM){
+            if(watchSignal == SIGUSR1){
+                watchSignal = 0;
+                watchReport(&stats);
+            }
+            //files from before the start, or lost in an overflow, are found in the folder;
+            //the ones taken already are skipped as retries
+            if(rescan){
+                rescan = 0;
+                if((folder = opendir(dir)) != NULL){
+                    while((entry = readdir(folder)) != NULL){
+                        watchQueue(dir, entry->d_name, seen, &stats, nThreads, outDir, cnt, type, param);
+                    }
+                    closedir(folder);
+                }
+            }
+            if(poll(&pfd, 1, 250) <= 0 || (len = read(pfd.fd, buff, sizeof(buff))) <= 0){
+                continue;
+            }
+            for(ptr = buff ; ptr < buff + len ; ptr += sizeof(struct inotify_event) + event->len){
+                event = (struct inotify_event*) ptr;
+                if(event->mask & IN_Q_OVERFLOW){
+                    fprintf(stderr, "ERROR: inotify queue overflow, rescanning %s\n", dir);
+                    rescan = 1;
+                }
+                if(event->len == 0 || (event->mask & IN_ISDIR)){
+                    continue;
+                }
+                watchQueue(dir, event->name, seen, &stats, nThreads, outDir, cnt, type, param);
+            }
+        }
+        #pragma omp taskwait
+    }
+
+    close(pfd.fd);
+    watchReport(&stats);
+    return 1;
+}
+
+//=================================================================================
+// Function watchQueue() hands a file of the watched folder to a worker task,
+// unless it is hidden, not a regular file or a retry of a file taken before.
+//=================================================================================
+void watchQueue(char dir[], char name[], watchKey seen[], watchStats *stats, int nThreads,
+                char outDir[], int cnt, int type[], int param[])
+{
+    struct stat   st;
+    char         *job;
+    double        start = watchClock();
+    int           depth;
+
+    if(name[0] == '.' || (job = (char*)malloc(strlen(dir) + strlen(name) + 2)) == NULL){
+        return;
+    }
+    sprintf(job, "%s/%s", dir, name);
+    if(stat(job, &st) != 0 || !S_ISREG(st.st_mode)){
+        free(job);
+        return;
+    }
+    if(watchSeen(seen, name, st.st_size, st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec)){
+        #pragma omp critical(watchStats)
+        stats->duplicates++;
+        free(job);
+        return;
+    }
+
+    #pragma omp critical(watchStats)
+    {
+        stats->queued++;
+        depth = stats->queued - stats->done - stats->failed;
+        stats->maxDepth = (depth > stats->maxDepth)? depth : stats->maxDepth;
+    }
+    //with one thread the file runs right here, nobody else would take it
+    #pragma omp task firstprivate(job, start) if(nThreads > 1)
+    {
+        watchFile(job, outDir, start, stats, cnt, type, param);
+        free(job);
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * int watchFile(char [], char [], double, watchStats *, int, int *, int *)
+ * 
+ * Description:
+ *   runs the options on every frame of one watched file and writes them into
+ *   outDir, then counts the file as done or failed with its latency since start.
+ *   The output is written under a hidden temp name and renamed once complete,
+ *   so readers of outDir never see half of a file; a failure removes it.
+ * Return:
+ *  returns 1 if successful; else 0
+ *
+ *=================================================================================
+ */
+int watchFile(char path[], char outDir[], double start, watchStats *stats, int cnt, int type[], int param[])
+{
+    fileType     img;
+    FILE        *fpIn;
+    FILE        *fpOut = NULL;
+    char        *name = strrchr(path, '/') + 1;
+    char        *outName;
+    char        *finalName = NULL;
+    char        *tempName;
+    int          status;
+    int          frames = 0;
+    int          serial;
+    int          depth;
+    double       ms;
+
+    outName = (char*)malloc(strlen(outDir) + strlen(name) + 2);
+    tempName = (char*)malloc(strlen(outDir) + strlen(name) + 32);
+    fpIn = fopen(path, "rb");
+    status = (fpIn != NULL && outName != NULL && tempName != NULL)? 1 : -1;
+    if(status == 1){
+        sprintf(outName, "%s/%s", outDir, name);
+        //a file written again while its last run is busy gets a temp of its own
+        #pragma omp atomic capture
+        serial = ++watchTemp;
+        sprintf(tempName, "%s/.%s.%d.part", outDir, name, serial);
+    }
+
+    img.format.ppm = NULL;
+    while(status == 1 && (status = readFrame(fpIn, &img)) == 1){
+        if(!processFrame(&img, cnt, type, param) ||
+           (fpOut == NULL && ((finalName = outputName(outName)) == NULL || (fpOut = fopen(tempName, "wb")) == NULL)) ||
+           !writeImage(fpOut, img)){
+            status = -1;
+        }else if(statsMode){
+            lumaFinish(&luma);
+            #pragma omp critical(watchStats)
+            {
+                fprintf(fpLog, "%s: ", name);
+                lumaReport(&luma);
+            }
+        }
+        rasterFree(img.format.ppm);
+        img.format.ppm = NULL;
+        frames++;
+    }
+    rasterFree(img.format.ppm);
+    if(fpIn != NULL) fclose(fpIn);
+    if(fpOut != NULL && fclose(fpOut) != 0) status = -1;
+
+    status = (status == 0 && frames > 0);
+    if(fpOut != NULL && (!status || rename(tempName, finalName) != 0)){
+        unlink(tempName);
+        status = 0;
+    }
+    free(outName);
+    free(finalName);
+    free(tempName);
+    ms = watchClock() - start;
+    #pragma omp critical(watchStats)
+    {
+        if(status){
+            stats->done++;
+        }else{
+            stats->failed++;
+        }
+        stats->totalMs += ms;
+        stats->maxMs = (ms > stats->maxMs)? ms : stats->maxMs;
+        depth = stats->queued - stats->done - stats->failed;
+        fprintf(fpLog, "%s %s in %.1f ms, queue %d\n", name, status? "done" : "FAILED", ms, depth);
+        fflush(fpLog);
+    }
+    return status;
+}
+
+//=================================================================================
+// Function watchSeen() checks if the file was taken before with the same size
+// and time, else it remembers it. The files are kept by a 64 bit hash of the
+// name in 4 slots after it, a full group forgets one of them.
+//=================================================================================
+int watchSeen(watchKey seen[], char name[], long long size, long long mtime)
+{
+    unsigned long long  hash = 14695981039346656037ULL;
+    size_t              slot;
+    int                 i;
+    int                 empty = -1;
+
+    //FNV-1a, 0 marks a free slot
+    for(i = 0 ; name[i] != '\0' ; i++){
+        hash = (hash ^ (unsigned char) name[i]) * 1099511628211ULL;
+    }
+    hash += (hash == 0);
+    slot = hash % WATCH_SEEN;
+
+    for(i = 0 ; i < 4 ; i++){
+        if(seen[(slot + i) % WATCH_SEEN].name == hash){
+            if(seen[(slot + i) % WATCH_SEEN].size == size && seen[(slot + i) % WATCH_SEEN].mtime == mtime){
+                return 1;
+            }
+            empty = i;
+            break;
+        }
+        if(empty == -1 && seen[(slot + i) % WATCH_SEEN].name == 0){
+            empty = i;
+        }
+    }
+    slot = (slot + ((empty == -1)? (hash >> 32) % 4 : (size_t) empty)) % WATCH_SEEN;
+    seen[slot].name = hash;
+    seen[slot].size = size;
+    seen[slot].mtime = mtime;
+    return 0;
+}
+
+//=================================================================================
+// Function watchReport() prints the --watch counters.
+//=================================================================================
+void watchReport(watchStats *stats)
+{
+    #pragma omp critical(watchStats)
+    {
+        fprintf(fpLog, "%d done, %d failed, %d retries skipped, queue %d (max %d), latency mean %.1f ms, max %.1f ms\n",
+                stats->done, stats->failed, stats->duplicates, stats->queued - stats->done - stats->failed,
+                stats->maxDepth, (stats->done + stats->failed > 0)? stats->totalMs / (stats->done + stats->failed) : 0,
+                stats->maxMs);
+        fflush(fpLog);
+    }
+}
+
+//=================================================================================
+// Function watchClock() gets a monotonic time in milliseconds.
+//=================================================================================
+double watchClock()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+//=================================================================================
+// Function watchHandler() keeps the signal for the --watch loop.
+//=================================================================================
+void watchHandler(int sig)
+{
+    watchSignal = sig;
+}
+#else
+int watchFolder(char dir[], char outDir[], int cnt, int type[], int param[])
+{
+    fprintf(stderr, "ERROR: --watch needs Linux (inotify)");
+    return 0;
+}
+#endif
+
+/*
+ *=================================================================================
+ *
+ * int processInPlace(fileType *, int, int)
+ * 
+ * Description:
+ *   runs one option on a single raster. Flips, quarter turns, -gray and -mono
+ *   work inside img; -w and other angles need the new raster, the old one is
+ *   freed right after.
+ * Return:
+ *   returns 1 if successful; else 0.    
+ *
+ *=================================================================================
+ */
+int processInPlace(fileType *img, int type, int param)
+{
+    fileType     out;
+    fileFormat   pgm;
+    int          i;
+
+    out.format.ppm = NULL;
+    out.size = 0;
+
+    switch(type){
+        case 1:
+            flipVerticalInPlace(&img->format, headerInfo[0], headerInfo[1]);
+            return 1;
+        case 2:
+            flipHorizontalInPlace(&img->format, headerInfo[0], headerInfo[1]);
+            return 1;
+        case 3:
+            if(!rescaleWidth(&out, &img->format, param, headerInfo[0], headerInfo[1])){
+                rasterFree(out.format.ppm);
+                return 0;
+            }
+            break;
+        case 4:
+            if(param == 180){
+                rotate180InPlace(&img->format, headerInfo[0], headerInfo[1]);
+                return 1;
+            }
+            //90 = flip vertical + transpose, 270 = transpose + flip vertical
+            if(param == 90 || param == 270){
+                if(param == 90){
+                    flipVerticalInPlace(&img->format, headerInfo[0], headerInfo[1]);
+                }
+                if(!transposeInPlace(&img->format, headerInfo[0], headerInfo[1])){
+                    return 0;
+                }
+                i = headerInfo[0];
+                headerInfo[0] = headerInfo[1];
+                headerInfo[1] = i;
+                if(param == 270){
+                    flipVerticalInPlace(&img->format, headerInfo[0], headerInfo[1]);
+                }
+                return 1;
+            }
+            if(param == 0){
+                return 1;
+            }
+            if(!rotateAuto(&out, &img->format, param, headerInfo[0], headerInfo[1])){
+                rasterFree(out.format.ppm);
+                return 0;
+            }
+            break;
+        case 5:
+        case 6:
+            //gray pixel i only overwrites bytes of RGB pixels already read
+            toGrayScale(&img->format, &img->format, headerInfo[0], headerInfo[1]);
+            if(type == 5){
+                pgm.pgm = img->format.pgm;
+                dithering(&img->format, &pgm, headerInfo[0], headerInfo[1]);
+            }
+            fType[1] = (type == 5)? '4': '5';
+            return allocMem(img);
+        default:
+            return 0;
+    }
+
+    rasterFree(img->format.ppm);
+    *img = out;
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int allocMem(fileType *)
+ * 
+ * Description:
+ *   Allocates a chunk of memory based on the file format. Any size that fits
+ *   in size_t is taken, big ones end up in a mapped temp file (rasterAlloc()).
+ * Return:
+ *   returns 1 if successful; else 0.                   
+ *            
+ *=================================================================================
+ */
+int allocMem(fileType *out)
+{
+    //the sizes below cannot wrap around
+    if(headerInfo[0] < 0 || headerInfo[1] < 0 || (headerInfo[1] > 0 &&
+       (size_t) headerInfo[0] > (size_t) -1 / sizeof(PPM) / (size_t) headerInfo[1])){
+        return 0;
+    }
+
+    //allocates memory accoring to its file type
+    switch(fType[1]){
+        case '6':
+            out->size = sizeof(PPM) * (size_t) headerInfo[0] * headerInfo[1]; 
+            out->format.ppm = (PPM*)rasterAlloc(out->size);
+            break;
+        case '5':
+            out->size = sizeof(PGM) * (size_t) headerInfo[0] * headerInfo[1];
+            out->format.pgm = (PGM*)rasterRealloc(out->format.ppm, out->size);
+            break;
+        case '4': 
+            //8 pixels per byte and every row starts on a new byte
+            out->size = sizeof(PBM) * (size_t) headerInfo[1] * ((headerInfo[0] + 7) / 8);
+            out->format.pbm = (PBM*)rasterRealloc(out->format.ppm, out->size);
+            break;
+
+        default : 
+            fprintf(fpLog, "ERROR: wrong file format");
+            return 0;
+    }
+
+    return (out->format.ppm == NULL) ? 0: 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * void *rasterAlloc(size_t)
+ * 
+ * Description:
+ *   allocates an image buffer. From mapFrom bytes (--mapped, or half of the free
+ *   memory) the buffer is a shared mapping of an unlinked temp file in $TMPDIR
+ *   (/var/tmp by default) so the system writes cold pages back to disk instead
+ *   of running out of memory. Falls back to malloc() if the mapping fails.
+ * Return:
+ *   returns the buffer; NULL if there is no memory.
+ *
+ *=================================================================================
+ */
+void *rasterAlloc(size_t size)
+{
+#ifndef _WIN32
+    char    path[512];
+    char   *dir;
+    void   *addr = MAP_FAILED;
+    int     fd;
+    int     i = MAP_SLOTS;
+
+    if(mapFrom != 0 && size >= mapFrom){
+        dir = getenv("TMPDIR");
+        snprintf(path, sizeof(path), "%s/ppmxXXXXXX", (dir != NULL)? dir : "/var/tmp");
+        if((fd = mkstemp(path)) != -1){
+            unlink(path);
+            if(ftruncate(fd, (off_t) size) == 0){
+                addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+        }
+        if(addr != MAP_FAILED){
+            #pragma omp critical(mapTable)
+            {
+                for(i = 0 ; i < MAP_SLOTS && mapped[i].addr != NULL ; i++);
+                if(i < MAP_SLOTS){
+                    mapped[i].addr = addr;
+                    mapped[i].length = size;
+                }
+            }
+            if(i < MAP_SLOTS){
+                return addr;
+            }
+            munmap(addr, size);
+        }
+    }
+#endif
+    return malloc(size);
+}
+
+//=================================================================================
+// Function rasterRealloc() resizes a buffer from rasterAlloc(), a NULL buffer is a
+// new rasterAlloc(). A mapping that shrinks stays where it is, the tail is given
+// back by rasterFree().
+//=================================================================================
+void *rasterRealloc(void *addr, size_t size)
+{
+    void    *out;
+    size_t   length = 0;
+    int      i;
+
+    //new rasters of every type go through the mapping size check
+    if(addr == NULL){
+        return rasterAlloc(size);
+    }
+    #pragma omp critical(mapTable)
+    for(i = 0 ; i < MAP_SLOTS ; i++){
+        if(mapped[i].addr == addr){
+            length = mapped[i].length;
+        }
+    }
+    if(length == 0){
+        return realloc(addr, size);
+    }
+    if(size <= length){
+        return addr;
+    }
+    if((out = rasterAlloc(size)) != NULL){
+        memcpy(out, addr, length);
+        rasterFree(addr);
+    }
+    return out;
+}
+
+//=================================================================================
+// Function rasterFree() frees a buffer from rasterAlloc(), malloc() or realloc().
+//=================================================================================
+void rasterFree(void *addr)
+{
+    size_t   length = 0;
+    int      i;
+
+    if(addr == NULL){
+        return;
+    }
+    #pragma omp critical(mapTable)
+    for(i = 0 ; i < MAP_SLOTS ; i++){
+        if(mapped[i].addr == addr){
+            length = mapped[i].length;
+            mapped[i].addr = NULL;
+        }
+    }
+#ifndef _WIN32
+    if(length != 0){
+        munmap(addr, length);
+        return;
+    }
+#endif
+    free(addr);
+}
+
+/*
+ *=================================================================================
+ *
+ * int readHeader(FILE *)
+ * 
+ * Description:
+ *   reads the header of the file and parse the content of the header                                                               
+ * Return:
+ *   returns 1 if successful; 0 if the file ends before the header does.
+ *
+ *=================================================================================
+ */
+int readHeader(FILE *fp)
+{
+    int     ch = 0;
+    int     i = 0;
+    int     cnt = 0;
+    int     isComment = 0;
+    int     isValue = 0;
+    char    buff[10];
+    
+    //to get the 3 data (width, height, maximum size)   
+    while(cnt <3){
+        if((ch = fgetc(fp)) == EOF){
+            return 0;
+        }
+        //check the #comment strings                                
+        if(ch != '#' && isComment != 1){
+            //find the first character of the data
+            if(!isspace(ch)){
+                if(i < 9) buff[i++] = ch;
+            //last character of the data and then add '\0'  
+            }else if(i > 0){
+                buff[i] = '\0';
+                //stores integer data in headerInfo
+                headerInfo[cnt++] = atoi(buff);
+                //this indicates that no data is found yet
+                i = 0;
+            }
+        }else{
+            //flags the start and the end of the comment
+            isComment = (ch == 10)? 0: 1;
+        }   
+    }
+    return 1;
+}
+
+//=================================================================================
+// Function scaledHeight() gives the height of -w<newWidth> in 64 bit, or 0 with
+// an error when it does not fit into an int (a thin strip scaled up a lot).
+//=================================================================================
+int scaledHeight(int width, int height, int newWidth)
+{
+    long long   newHeight = (long long) ceil((float) height / width * newWidth);
+
+    if(newHeight > INT_MAX){
+        fprintf(stderr, "ERROR: -w%d makes the image %lld pixels high\n", newWidth, newHeight);
+        return 0;
+    }
+    return (int) newHeight;
+}
+
+/*
+ *=================================================================================
+ *
+ * int rescaleWidth(fileType *, fileFormat *, int , int, int )
+ * 
+ * Description:
+ *    resize the image given new width and P6 image using bilinear interpolation.
+ * Return:
+ *  returns 1 if successful; else 0.    
+ *
+ *=================================================================================
+ */
+int rescaleWidth(fileType *out, fileFormat *src, int newWidth, int width, int height)
+{
+    int     y;
+    int     yDiff;
+    int     i;
+    int     newHeight;
+    float   xRatio;
+    float   yRatio;
+    
+    //free the pre allocated memory to reallocate bigger memory
+    rasterFree(out->format.ppm);
+    out->format.ppm = NULL;
+    
+    if((newHeight = scaledHeight(width, height, newWidth)) == 0){
+        return 0;
+    }
+    headerInfo[0] = newWidth;
+    headerInfo[1] = newHeight;
+
+    if(!allocMem(out)){
+        return 0;
+    }
+
+    xRatio = ( (float) width - 1) / headerInfo[0];
+    yRatio = ( (float) height - 1) / headerInfo[1];
+    
+    //every output row reads 2 source rows, rows are independent
+    #pragma omp parallel for private(y, yDiff)
+    for(i = 0; i < newHeight; i++ ){
+        y = yRatio * i;
+        yDiff = (yRatio * i) - y;
+        rescaleRow(out->format.ppm + (size_t) i * newWidth, src->ppm + (size_t) y * width,
+                   src->ppm + (size_t) ((y + 1 < height)? y + 1 : y) * width, newWidth, width, xRatio, yDiff);
+    }
+    return 1;
+}
+
+//=================================================================================
+// Function rescaleRow() makes one row of rescaleWidth() out of the source rows
+// above and below it. The row stream uses it too.
+//=================================================================================
+void rescaleRow(PPM *out, PPM *top, PPM *bottom, int newWidth, int width, float xRatio, int yDiff)
+{
+    PPM     pxl[4];
+    int     x;
+    int     xDiff;
+    int     j;
+
+    for(j=0; j < newWidth; j++){
+
+        x = xRatio * j;
+        xDiff = (xRatio * j) - x;
+
+        //the last column has no right neighbour
+        pxl[0] = top[x];
+        pxl[1] = top[(x + 1 < width)? x + 1 : x];
+        pxl[2] = bottom[x];
+        pxl[3] = bottom[(x + 1 < width)? x + 1 : x];
+
+        //using bilinear interpolation algorithm for R G B
+        
+        out[j].R = (PXL) (pxl[0].R * (1 - xDiff) * (1 - yDiff) + pxl[1].R * xDiff * (1 - yDiff) +
+                pxl[2].R * yDiff * (1 - xDiff) + pxl[3].R * (xDiff * yDiff));
+
+        out[j].G = (PXL) (pxl[0].G * (1 - xDiff) * (1 - yDiff) + pxl[1].G * xDiff * (1 - yDiff) +
+                pxl[2].G * yDiff * (1 - xDiff) + pxl[3].G * (xDiff * yDiff));
+
+        out[j].B = (PXL) (pxl[0].B * (1 - xDiff) * (1 - yDiff) + pxl[1].B * xDiff * (1 - yDiff) +
+                pxl[2].B * yDiff * (1 - xDiff) + pxl[3].B * (xDiff * yDiff));
+    }
+}
+
+//=================================================================================
+// Function round() rounds the value. This is used in function rotateImage().     
+//=================================================================================
+double round(double val)
+{    
+    return floor(val + 0.5);
+}
+
+//=================================================================================
+// Function rotate90() rotates the image in 90 degrees.                           
+//=================================================================================
+void rotate90(fileType *out, fileFormat *src, int width, int height)
+{
+    quarterTurn(out->format.ppm, src->ppm, 1, width, height);
+}
+
+//=================================================================================
+// Function quarterTurn() rotates the image by turns * 90 degrees CW into out in
+// one pass. It walks ROT_TILE x ROT_TILE tiles: a source row would write a whole
+// output column, one pixel per output row and page.
+//=================================================================================
+void quarterTurn(PPM *out, PPM *src, int turns, int width, int height)
+{
+    int     i;
+    int     j;
+    int     x;
+    int     y;
+
+    #pragma omp parallel for private(i, x, y)
+    for(j = 0 ; j < height ; j += ROT_TILE){
+        for(i = 0 ; i < width ; i += ROT_TILE){
+            for(y = j ; y < height && y < j + ROT_TILE ; y++){
+                for(x = i ; x < width && x < i + ROT_TILE ; x++){
+                    if(turns == 1){
+                        out[(size_t) x * height + height - 1 - y] = src[(size_t) y * width + x];
+                    }else if(turns == 2){
+                        out[(size_t) (height - 1 - y) * width + width - 1 - x] = src[(size_t) y * width + x];
+                    }else{
+                        out[(size_t) (width - 1 - x) * height + y] = src[(size_t) y * width + x];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * int rotateImage(fileType *, fileFormat *, int, int ,int)
+ * 
+ * Description:
+ *   rotates P6 PPM image using biliniear interpolation   
+ * Return:
+ *   returns 1 if successful; else 0;                         
+ *
+ *=================================================================================
+ */
+int rotateImage(fileType *out, fileFormat *src, int angle, int width, int height)
+{
+    const double cnAngle = (angle * M_PI / 180);
+    int          i;
+    int          j;
+    int          x;
+    int          y;
+    int          iFloorX;
+    int          iCeilingX;
+    int          iFloorY;
+    int          iCeilingY;
+    int          iCentreX;
+    int          iCentreY;
+    int          iDestCentreX;
+    int          iDestCentreY;
+    int          iWidth;
+    int          iHeight;
+    int          iTilesX;
+    int          t;
+    double       fDistance;
+    double       fPolarAngle;
+    double       fTrueX;
+    double       fTrueY;
+    double       fDeltaX;
+    double       fDeltaY;
+    double       fTopRed;
+    double       fTopGreen;
+    double       fTopBlue;
+    double       fBottomRed;
+    double       fBottomGreen;
+    double       fBottomBlue;
+    PPM          color[4];
+    PPM          tempRGB;
+
+
+    //pythagorean theorem
+    //sin(angle) * hypotenuse + cos(angle) * hypotenuse 
+    iWidth  = ceil( abs(sin(cnAngle) * headerInfo[1]) + abs(cos(cnAngle) * headerInfo[0]));
+    iHeight = ceil( abs(sin(cnAngle) * headerInfo[0]) + abs(cos(cnAngle) * headerInfo[1]));
+
+    iCentreX = width / 2;
+    iCentreY = height / 2;
+
+    iDestCentreX = iWidth / 2;
+    iDestCentreY = iHeight / 2;
+    headerInfo[0] = iWidth;
+    headerInfo[1] = iHeight;
+
+    rasterFree(out->format.ppm);
+    out->format.ppm = NULL;
+    if(!allocMem(out)){
+        return 0;
+    }
+    
+    //angles 0, 180, 90 and 270 should have a different function and should not reuse flips and rotate90
+    //planning to revise
+    if(angle == 0){
+        memcpy(out->format.ppm, src->ppm, out->size);
+        return 1;
+    }
+    if(angle == 180){
+        flipHorizontal(out, src, width, height);
+        memcpy(src->ppm, out->format.ppm, out->size);
+        flipVertical(out, src, width, height);
+        return 1;
+    }
+    if(angle == 90){
+        rotate90(out, src, width, height);
+        return 1;
+    }
+    if(angle == 270){
+        rotate90(out, src, width, height);
+        memcpy(src->ppm, out->format.ppm, out->size);
+        flipVertical(out,src,height,width);
+        memcpy(src->ppm, out->format.ppm, out->size);
+        flipHorizontal(out,src,height,width);
+        return 1;
+    }
+
+
+    memset(out->format.ppm, 0, out->size);
+    
+    //a tile of the output reads a small patch of the source, a whole output row
+    //would read a diagonal line through all of the source rows
+    iTilesX = (iWidth + ROT_TILE - 1) / ROT_TILE;
+    #pragma omp parallel for schedule(dynamic) private(i, j, x, y, iFloorX, iCeilingX, iFloorY, iCeilingY, \
+            fDistance, fPolarAngle, fTrueX, fTrueY, fDeltaX, fDeltaY, fTopRed, fTopGreen, fTopBlue,      \
+            fBottomRed, fBottomGreen, fBottomBlue, color, tempRGB)
+    for(t = 0 ; t < iTilesX * ((iHeight + ROT_TILE - 1) / ROT_TILE) ; t++){
+        for(i = t / iTilesX * ROT_TILE ; i < iHeight && i < (t / iTilesX + 1) * ROT_TILE ; ++i){
+            
+            for(j = t % iTilesX * ROT_TILE ; j < iWidth && j < (t % iTilesX + 1) * ROT_TILE ; ++j){
+                x = j - iDestCentreX;
+                y = iDestCentreY - i;
+
+                fDistance = sqrt((double) x * x + (double) y * y);
+                fPolarAngle = 0.0;
+                if(x == 0){
+                    fPolarAngle = (y < 0)? 1.5 * M_PI : 0.5 * M_PI;
+                }else{
+                    fPolarAngle = atan2(y,x);
+                }
+
+                fPolarAngle += cnAngle;
+                
+                fTrueX = fDistance * cos(fPolarAngle);
+                fTrueY = fDistance * sin(fPolarAngle);
+
+                fTrueX +=iCentreX;
+                fTrueY = iCentreY - fTrueY;
+
+                iFloorX = floor(fTrueX);
+                iFloorY = floor(fTrueY);
+                iCeilingX = ceil(fTrueX);
+                iCeilingY = ceil(fTrueY);
+                
+                // check bounds
+                if (iFloorX < 0 || iCeilingX < 0 || iFloorX >= width || iCeilingX >= width || iFloorY < 0 || iCeilingY < 0 || iFloorY >= height || iCeilingY >= height) continue;
+                
+                fDeltaX = fTrueX - iFloorX;
+                fDeltaY = fTrueY - iFloorY;
+
+                //colors from topleft, topright, bottomleft and bottomright respectively
+                color[0] = *(src->ppm + iFloorX + (size_t) iFloorY * width);
+                color[1] = *(src->ppm + iCeilingX + (size_t) iFloorY * width);
+                color[2] = *(src->ppm + iFloorX + (size_t) iCeilingY * width);
+                color[3] = *(src->ppm + iCeilingX + (size_t) iCeilingY * width);
+                
+                // linearly interpolate horizontally between top neighbours
+                fTopRed = (1 - fDeltaX) * color[0].R + fDeltaX * color[1].R;
+                fTopGreen = (1 - fDeltaX) * color[0].G + fDeltaX * color[1].G;
+                fTopBlue = (1 - fDeltaX) * color[0].B + fDeltaX * color[1].B;
+
+                // linearly interpolate horizontally between bottom neighbours
+                fBottomRed = (1 - fDeltaX) * color[2].R + fDeltaX * color[3].R;
+                fBottomGreen = (1 - fDeltaX) * color[2].G + fDeltaX * color[3].G;
+                fBottomBlue = (1 - fDeltaX) * color[2].B + fDeltaX * color[3].B;
+
+                // linearly interpolate vertically between top and bottom interpolated results
+                tempRGB.R = round((1 - fDeltaY) * fTopRed + fDeltaY * fBottomRed);
+                tempRGB.G = round((1 - fDeltaY) * fTopGreen + fDeltaY * fBottomGreen);
+                tempRGB.B = round((1 - fDeltaY) * fTopBlue + fDeltaY * fBottomBlue);
+
+                memcpy(out->format.ppm + j + (size_t) i * iWidth, &tempRGB, sizeof(PPM));
+                
+            }
+        }
+    }
+
+    return 1;
+}
+
+//=================================================================================
+// Function shearRow() resamples a row moved by a fractional offset. Destination
+// pixels outside the source row are left black.
+//=================================================================================
+void shearRow(PPM *out, int outWidth, PPM *src, int srcWidth, double offset)
+{
+    int     j;
+    int     lo;
+    int     hi;
+    int     iFloor = (int) floor(offset);
+    int     f = (int) round((offset - iFloor) * 256);
+    PPM     *p;
+
+    if(f == 256){
+        iFloor++;
+        f = 0;
+    }
+    memset(out, 0, sizeof(PPM) * outWidth);
+
+    //both neighbours are inside the source for lo <= j < hi
+    lo = (-iFloor > 0)? -iFloor : 0;
+    hi = (srcWidth - 1 - iFloor < outWidth)? srcWidth - 1 - iFloor : outWidth;
+    for(j = lo ; j < hi ; j++){
+        p = src + j + iFloor;
+        out[j].R = (p[0].R * (256 - f) + p[1].R * f + 128) >> 8;
+        out[j].G = (p[0].G * (256 - f) + p[1].G * f + 128) >> 8;
+        out[j].B = (p[0].B * (256 - f) + p[1].B * f + 128) >> 8;
+    }
+    //edges fade against the black background
+    if(lo - 1 >= 0 && lo - 1 < outWidth && lo - 1 + iFloor + 1 < srcWidth){
+        p = src + lo + iFloor;
+        out[lo-1].R = (p->R * f + 128) >> 8;
+        out[lo-1].G = (p->G * f + 128) >> 8;
+        out[lo-1].B = (p->B * f + 128) >> 8;
+    }
+    if(hi >= 0 && hi < outWidth && hi + iFloor >= 0){
+        p = src + hi + iFloor;
+        out[hi].R = (p->R * (256 - f) + 128) >> 8;
+        out[hi].G = (p->G * (256 - f) + 128) >> 8;
+        out[hi].B = (p->B * (256 - f) + 128) >> 8;
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * int rotateAuto(fileType *, fileFormat *, int, int ,int)
+ * 
+ * Description:
+ *   rotates with the engine picked by -rb/-rs/-rc. Plain -r uses the 3-shear
+ *   engine from SHEAR_MIN_PIXELS since it is cache friendly on large images,
+ *   except in --inplace mode: its passes take several rasters, bilinear one.
+ * Return:
+ *   returns 1 if successful; else 0;                         
+ *
+ *=================================================================================
+ */
+int rotateAuto(fileType *out, fileFormat *src, int angle, int width, int height)
+{
+    if(rotEngine == 'b' || (rotEngine == 'a' && (inPlace || (long long) width * height < SHEAR_MIN_PIXELS))){
+        return rotateImage(out, src, angle, width, height);
+    }
+    if(!rotateShear(out, src, angle, width, height)){
+        return 0;
+    }
+    return (rotEngine == 'c')? compareRotation(out, src, angle, width, height) : 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int rotateShear(fileType *, fileFormat *, int, int ,int)
+ * 
+ * Description:
+ *   rotates P6 PPM image by three 1D shears (x, y, x). Quarter turns are done
+ *   first by quarterTurn() so the shears only cover -45 to 45 degrees. Every pass
+ *   walks the buffers row by row instead of diagonally like rotateImage().
+ * Return:
+ *   returns 1 if successful; else 0;                         
+ *
+ *=================================================================================
+ */
+int rotateShear(fileType *out, fileFormat *src, int angle, int width, int height)
+{
+    int          i;
+    int          j;
+    int          k;
+    int          turns;
+    int          iWidth;
+    int          iHeight;
+    int          iDestCentreX;
+    int          iDestCentreY;
+    int          iCentreX;
+    int          iCentreY;
+    int          iWidth1;
+    int          iHeight2;
+    int          iCentreX1;
+    int          iCentreY2;
+    int         *rowIdx  = NULL;
+    int         *rowFrac = NULL;
+    double       fShearX;
+    double       fShearY;
+    double       fResidual;
+    PPM         *base;
+    PPM         *pass1 = NULL;
+    PPM         *pass2 = NULL;
+    PPM         *p0;
+    PPM         *p1;
+    PPM         *q;
+    PPM          black = {0, 0, 0};
+
+    //orthogonal angles have their own exact path
+    if(angle % 90 == 0){
+        return rotateImage(out, src, angle, width, height);
+    }
+
+    //same output size as rotateImage()
+    iWidth  = (int) fabs(sin(angle * M_PI / 180) * height) + (int) fabs(cos(angle * M_PI / 180) * width);
+    iHeight = (int) fabs(sin(angle * M_PI / 180) * width) + (int) fabs(cos(angle * M_PI / 180) * height);
+    iDestCentreX = iWidth / 2;
+    iDestCentreY = iHeight / 2;
+    iCentreX = width / 2;
+    iCentreY = height / 2;
+
+    //quarter turns so that the residual angle stays within -45 to 45
+    turns = (angle + 45) / 90;
+    fResidual = (angle - 90 * turns) * M_PI / 180;
+    base = src->ppm;
+    //the whole quarter turn is one tiled pass
+    if((turns %= 4) > 0){
+        base = (PPM*)rasterAlloc(sizeof(PPM) * width * height);
+        if(base == NULL){
+            return 0;
+        }
+        quarterTurn(base, src->ppm, turns, width, height);
+    }
+    for( ; turns > 0 ; turns--){
+        //the centre pixel follows every quarter turn
+        i = iCentreX;
+        iCentreX = height - 1 - iCentreY;
+        iCentreY = i;
+        i = width;
+        width = height;
+        height = i;
+    }
+
+    //R = shearX(a) * shearY(b) * shearX(a), walked backwards from the output
+    fShearX = -tan(fResidual / 2);
+    fShearY = sin(fResidual);
+    iWidth1 = width + (int) ceil(fabs(fShearX) * height) + 2;
+    iCentreX1 = iWidth1 / 2;
+    iHeight2 = height + (int) ceil(fabs(fShearY) * iWidth1) + 2;
+    iCentreY2 = iHeight2 / 2;
+
+    headerInfo[0] = iWidth;
+    headerInfo[1] = iHeight;
+    rasterFree(out->format.ppm);
+    out->format.ppm = NULL;
+
+    //every pass is allocated once the one before it is freed, so no more than
+    //two of the rasters are alive at the same time
+    pass1   = (PPM*)rasterAlloc(sizeof(PPM) * iWidth1 * height);
+    rowIdx  = (int*)malloc(sizeof(int) * iWidth1);
+    rowFrac = (int*)malloc(sizeof(int) * iWidth1);
+    if(pass1 == NULL || rowIdx == NULL || rowFrac == NULL){
+        if(base != src->ppm) rasterFree(base);
+        rasterFree(pass1);
+        free(rowIdx);
+        free(rowFrac);
+        return 0;
+    }
+
+    //first x shear: one constant offset per row
+    #pragma omp parallel for
+    for(i = 0 ; i < height ; i++){
+        shearRow(pass1 + (size_t) i * iWidth1, iWidth1, base + (size_t) i * width, width,
+                 iCentreX - iCentreX1 - fShearX * (i - iCentreY));
+    }
+    if(base != src->ppm) rasterFree(base);
+
+    pass2 = (PPM*)rasterAlloc(sizeof(PPM) * iWidth1 * iHeight2);
+    if(pass2 == NULL){
+        rasterFree(pass1);
+        free(rowIdx);
+        free(rowFrac);
+        return 0;
+    }
+
+    //y shear: one constant offset per column, still written row by row
+    for(j = 0 ; j < iWidth1 ; j++){
+        fResidual = iCentreY - iCentreY2 - fShearY * (j - iCentreX1);
+        rowIdx[j] = (int) floor(fResidual);
+        rowFrac[j] = (int) round((fResidual - rowIdx[j]) * 256);
+        if(rowFrac[j] == 256){
+            rowIdx[j]++;
+            rowFrac[j] = 0;
+        }
+    }
+    //strips of ROT_TILE columns: a row of a strip reads from a few pass1 rows only,
+    //a whole row would read from up to fShearY * iWidth1 of them
+    #pragma omp parallel for private(i, j, p0, p1, q)
+    for(k = 0 ; k < iWidth1 ; k += ROT_TILE){
+        for(i = 0 ; i < iHeight2 ; i++){
+            q = pass2 + (size_t) i * iWidth1;
+            for(j = k ; j < iWidth1 && j < k + ROT_TILE ; j++){
+                p0 = (i + rowIdx[j] >= 0 && i + rowIdx[j] < height)?
+                     pass1 + (size_t) (i + rowIdx[j]) * iWidth1 + j : &black;
+                p1 = (i + rowIdx[j] + 1 >= 0 && i + rowIdx[j] + 1 < height)?
+                     pass1 + (size_t) (i + rowIdx[j] + 1) * iWidth1 + j : &black;
+                q[j].R = (p0->R * (256 - rowFrac[j]) + p1->R * rowFrac[j] + 128) >> 8;
+                q[j].G = (p0->G * (256 - rowFrac[j]) + p1->G * rowFrac[j] + 128) >> 8;
+                q[j].B = (p0->B * (256 - rowFrac[j]) + p1->B * rowFrac[j] + 128) >> 8;
+            }
+        }
+    }
+    rasterFree(pass1);
+    free(rowIdx);
+    free(rowFrac);
+    if(!allocMem(out)){
+        rasterFree(pass2);
+        return 0;
+    }
+
+    //second x shear straight into the output
+    #pragma omp parallel for private(j)
+    for(i = 0 ; i < iHeight ; i++){
+        j = i - iDestCentreY + iCentreY2;
+        if(j < 0 || j >= iHeight2){
+            memset(out->format.ppm + (size_t) i * iWidth, 0, sizeof(PPM) * iWidth);
+        }else{
+            shearRow(out->format.ppm + (size_t) i * iWidth, iWidth, pass2 + (size_t) j * iWidth1, iWidth1,
+                     iCentreX1 - iDestCentreX - fShearX * (i - iDestCentreY));
+        }
+    }
+
+    rasterFree(pass2);
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int compareRotation(fileType *, fileFormat *, int, int ,int)
+ * 
+ * Description:
+ *   runs the bilinear rotateImage() on the same source and prints how far the
+ *   shear result in out is from it (PSNR and largest channel difference).
+ * Return:
+ *   returns 1 if successful; else 0;                         
+ *
+ *=================================================================================
+ */
+int compareRotation(fileType *out, fileFormat *src, int angle, int width, int height)
+{
+    fileType     ref;
+    size_t       i;
+    int          diff;
+    int          maxDiff = 0;
+    double       sqError = 0;
+    int          info[2];
+
+    if(angle % 90 == 0){
+        fprintf(fpLog, "(shear = bilinear) ");
+        return 1;
+    }
+
+    info[0] = headerInfo[0];
+    info[1] = headerInfo[1];
+    headerInfo[0] = width;
+    headerInfo[1] = height;
+    ref.format.ppm = NULL;
+    if(!rotateImage(&ref, src, angle, width, height)){
+        return 0;
+    }
+    headerInfo[0] = info[0];
+    headerInfo[1] = info[1];
+
+    for(i = 0 ; i < out->size ; i++){
+        diff = abs(ref.format.pgm[i] - out->format.pgm[i]);
+        maxDiff = (diff > maxDiff)? diff : maxDiff;
+        sqError += diff * diff;
+    }
+    rasterFree(ref.format.ppm);
+
+    sqError /= out->size;
+    if(sqError == 0){
+        fprintf(fpLog, "(shear vs bilinear: identical) ");
+    }else{
+        fprintf(fpLog, "(shear vs bilinear: PSNR %.2f dB, max diff %d) ", 10 * log10(255.0 * 255.0 / sqError), maxDiff);
+    }
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * void toGrayScale(fileFormat *out, fileFormat *, int, int )
+ * 
+ * Description:
+ *   converts 3 bytes RGB pixel to 1 byte grayscale pixel. With --stats or
+ *   --adaptive every pixel is also counted into this thread's luma histogram,
+ *   so the statistics cost no pass of their own. Separate buffers are split
+ *   over the threads, each with its own histogram; in place stays serial since
+ *   the gray pixels overwrite colors other threads would still read.
+ *                                    
+ *=================================================================================
+ */
+void toGrayScale(fileFormat *out, fileFormat *src, int width, int height)
+{
+    size_t  i;
+    size_t  size;
+    PGM     grey;
+    PPM     *rgb;
+    int     counting = statsMode || adaptive;
+    unsigned long long hist[256];
+
+    size = (size_t) height * width;
+    memset(hist, 0, sizeof(hist));
+    #pragma omp parallel for private(rgb, grey) reduction(+:hist[:256]) if(out->pgm != src->pgm)
+    for(i=0; i < size; i++){
+        //gets the RGB pixels sequentially 
+        rgb = src->ppm + i;
+        //converts 3 bytes RGB pixel to 1 byte grayscaled pixel
+        grey = ((rgb->R * 299) + (rgb->G * 587) + (rgb->B * 114))/1000;
+        memcpy(out->pgm + i, &grey,sizeof(PGM));
+        if(counting){
+            hist[grey]++;
+        }
+    }
+
+    if(counting){
+        for(i = 0 ; i < 256 ; i++){
+            luma.hist[i] += hist[i];
+        }
+        luma.count += size;
+    }
+}
+
+//=================================================================================
+// Function lumaHistogram() counts the luma of a P6 image into this thread's
+// histogram, for --stats on color output where no gray conversion runs. The
+// frame is counted while it loads, see readFrame().
+//=================================================================================
+void lumaHistogram(fileFormat *src, int width, int height)
+{
+    size_t  i;
+    size_t  size = (size_t) height * width;
+    PPM     *rgb;
+    unsigned long long hist[256];
+
+    memset(hist, 0, sizeof(hist));
+    //a streamed row is counted by the thread that reads it
+    #pragma omp parallel for private(rgb) reduction(+:hist[:256]) if(height > 1)
+    for(i = 0 ; i < size ; i++){
+        rgb = src->ppm + i;
+        hist[((rgb->R * 299) + (rgb->G * 587) + (rgb->B * 114))/1000]++;
+    }
+    for(i = 0 ; i < 256 ; i++){
+        luma.hist[i] += hist[i];
+    }
+    luma.count += size;
+}
+
+/*
+ *=================================================================================
+ *
+ * void lumaFinish(lumaStats *)
+ * 
+ * Description:
+ *   derives min, max and mean from the histogram, the auto-level range (the
+ *   0.5% darkest and brightest pixels are clipped so a few specks do not hold
+ *   the range open) and the Otsu threshold that splits the histogram in the two
+ *   classes with the largest between-class variance (ink and paper on a scan).
+ *
+ *=================================================================================
+ */
+void lumaFinish(lumaStats *stats)
+{
+    int                 i;
+    unsigned long long  sum;
+    unsigned long long  clip = stats->count / 200;
+    double              total = 0;
+    double              below = 0;
+    double              weight = 0;
+    double              variance;
+    double              best = -1;
+
+    stats->min = stats->low = 0;
+    stats->max = stats->high = 255;
+    stats->mean = 0;
+    stats->threshold = 128;
+    if(stats->count == 0){
+        return;
+    }
+
+    for(i = 0 ; i < 256 && stats->hist[i] == 0 ; i++);
+    stats->min = i;
+    for(i = 255 ; i > 0 && stats->hist[i] == 0 ; i--);
+    stats->max = i;
+    for(i = 0, sum = 0 ; i < 255 && (sum += stats->hist[i]) <= clip ; i++);
+    stats->low = i;
+    for(i = 255, sum = 0 ; i > 0 && (sum += stats->hist[i]) <= clip ; i--);
+    stats->high = i;
+
+    for(i = 0 ; i < 256 ; i++){
+        total += (double) i * stats->hist[i];
+    }
+    stats->mean = total / stats->count;
+
+    for(i = 0 ; i < 255 ; i++){
+        weight += stats->hist[i];
+        below += (double) i * stats->hist[i];
+        if(weight == 0 || weight == stats->count){
+            continue;
+        }
+        //weights times the squared distance of the class means, over count^2
+        variance = below / weight - (total - below) / (stats->count - weight);
+        variance *= variance * weight * (stats->count - weight);
+        if(variance > best){
+            best = variance;
+            stats->threshold = i;
+        }
+    }
+}
+
+//=================================================================================
+// Function lumaTable() makes the 256 entry remap ditherRow() looks the gray up
+// in. --adaptive stretches low..high over 0..255 with the threshold on 128, the
+// middle of the bayer table; otherwise and on flat images gray stays as it is.
+//=================================================================================
+void lumaTable(PGM lut[])
+{
+    int     i;
+    int     t;
+
+    for(i = 0 ; i < 256 ; i++){
+        lut[i] = (PGM) i;
+    }
+    if(!adaptive || luma.count == 0){
+        return;
+    }
+    lumaFinish(&luma);
+    if(luma.high - luma.low < 16){
+        return;
+    }
+
+    t = (luma.threshold <= luma.low)? luma.low + 1 : (luma.threshold >= luma.high)? luma.high - 1 : luma.threshold;
+    for(i = 0 ; i < 256 ; i++){
+        if(i <= luma.low){
+            lut[i] = 0;
+        }else if(i >= luma.high){
+            lut[i] = 255;
+        }else if(i <= t){
+            lut[i] = (PGM) ((i - luma.low) * 128 / (t - luma.low));
+        }else{
+            lut[i] = (PGM) (128 + (i - t) * 127 / (luma.high - t));
+        }
+    }
+}
+
+//=================================================================================
+// Function lumaReport() prints the --stats of one frame.
+//=================================================================================
+void lumaReport(lumaStats *stats)
+{
+    fprintf(fpLog, "luma min %d, max %d, mean %.1f, levels %d-%d, threshold %d\n",
+            stats->min, stats->max, stats->mean, stats->low, stats->high, stats->threshold);
+}
+
+/*
+ *=================================================================================
+ *
+ * void dithering()
+ * 
+ * Description:
+ *   converts P5 PGM to P4 PBM using ordered dithering technique (bayer 4x4).
+ *   With --adaptive the gray goes through the lumaTable() remap of the
+ *   histogram toGrayScale() counted, inside the same loop.
+ *                                    
+ *=================================================================================
+ */
+void dithering(fileFormat *out, fileFormat *src, int width, int height)
+{
+    int     i;
+    PGM     lut[256];
+
+    lumaTable(lut);
+    //row i of the output never gets ahead of row i of the source
+    for(i = 0 ; i < height ; i++){
+        ditherRow(out->pbm + (size_t) i * ((width + 7) / 8), src->pgm + (size_t) i * width, width, i, lut);
+    }
+}
+
+//=================================================================================
+// Function ditherRow() dithers row y of a grayscale image into (width + 7) / 8
+// bytes, comparing lut[gray] to the bayer table. The row stream uses it too.
+//=================================================================================
+void ditherRow(PBM *out, PGM *src, int width, int y, PGM lut[])
+{
+    int     j;
+    int     n;
+    PBM     pbm;
+#if 0
+    int     bayer[8][8] = { { 96,  40,  48, 104, 140, 188, 196, 148},
+                            { 32,   4,   8,  56, 180, 236, 244, 204},
+                            { 88,  24,  16,  64, 172, 228, 252, 212},
+                            {120,  80,  72, 112, 132, 164, 220, 156},
+                            {136, 184, 192, 144, 100,  44,  52, 108},
+                            {176, 232, 240, 200,  36,   4,  12,  60},
+                            {168, 224, 248, 208,  92,  28,  20,  68},
+                            {128, 160, 216, 152, 124,  84,  76, 166}};
+#else
+     int    bayer[4][4] = {{ 16, 143,  47, 175},
+                           {207,  79, 239, 111},
+                           { 63, 191,  31, 159},
+                           {255, 127, 223,  95}};
+#endif  
+    for(j = 0 ; j < width ; ){
+        for(n = 128, pbm = 0 ; j < width && n > 0 ;  j++, n >>=1){
+            //masks old pixel to its corresponding bayer mask
+            pbm = (lut[src[j]] <= bayer[y % 4][j % 4])? pbm | n : pbm;  
+        }
+        //writes the 8 pixels (1 byte)
+        *out++ = pbm;
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * int convolve(fileType *, int, int)
+ * 
+ * Description:
+ *   runs -blur<radius>, -sharpen<amount> and -usm<radius>,<amount> on a P6 or P5
+ *   image. The blur is BOX_PASSES running-sum box blurs (close to a gaussian
+ *   with sigma about radius / 2 + 1, see boxRadii()) so the cost does not grow
+ *   with the radius. Sharpen is an unsharp mask with radius 1:
+ *   src + amount% * (src - blur). It runs on strips of SHARPEN_STRIP rows, each
+ *   blurred in a buffer with the halo rows of the radius above and below, so
+ *   the source stays the only full raster (--inplace keeps its promise).
+ * Return:
+ *   returns 1 if successful; else 0.
+ *
+ *=================================================================================
+ */
+int convolve(fileType *img, int type, int param)
+{
+    size_t          i;
+    size_t          stride;
+    int             channels = (fType[1] == '6')? 3 : 1;
+    int             radius = (type == 7)? param : (type == 8)? 1 : param / 1000;
+    int             amount = (type == 8)? param : param % 1000;
+    int             gain;
+    int             value;
+    int             box[BOX_PASSES];
+    int             halo;
+    int             rows;
+    int             y0;
+    int             y1;
+    int             top;
+    int             bottom;
+    PXL            *blur;
+    PXL            *above;
+    PXL            *src = img->format.pgm;
+
+    boxRadii(radius, box);
+    if(type == 7){
+        return boxBlur(src, box, channels, headerInfo[0], headerInfo[1]);
+    }
+
+    //a strip needs the source rows of all passes' radii above and below it
+    for(halo = 0, i = 0 ; i < BOX_PASSES ; i++){
+        halo += box[i];
+    }
+    rows = (SHARPEN_STRIP > 2 * halo)? SHARPEN_STRIP : 2 * halo;
+    stride = (size_t) headerInfo[0] * channels;
+    bottom = (rows + 2 * halo < headerInfo[1])? rows + 2 * halo : headerInfo[1];
+    blur = (PXL*)rasterAlloc(stride * bottom + 1);
+    above = (PXL*)malloc(stride * halo + 1);
+    if(blur == NULL || above == NULL){
+        rasterFree(blur);
+        free(above);
+        return 0;
+    }
+
+    //amount in 8 bit fixed point, the offset keeps the shift on positive values
+    gain = amount * 256 / 100;
+    for(y0 = 0 ; y0 < headerInfo[1] ; y0 = y1){
+        y1 = (y0 + rows < headerInfo[1])? y0 + rows : headerInfo[1];
+        top = (y0 - halo > 0)? y0 - halo : 0;
+        bottom = (y1 + halo < headerInfo[1])? y1 + halo : headerInfo[1];
+
+        //the rows above the strip are sharpened already, their originals were kept
+        memcpy(blur, above, stride * (y0 - top));
+        memcpy(blur + stride * (y0 - top), src + stride * y0, stride * (bottom - y0));
+        if(!boxBlur(blur, box, channels, headerInfo[0], bottom - top)){
+            rasterFree(blur);
+            free(above);
+            return 0;
+        }
+        if(y1 < headerInfo[1]){
+            memcpy(above, src + stride * (y1 - halo), stride * halo);
+        }
+
+        #pragma omp parallel for private(value)
+        for(i = stride * y0 ; i < stride * y1 ; i++){
+            value = src[i] + (((src[i] - blur[i - stride * top]) * gain + (1 << 24) + 128) >> 8) - (1 << 16);
+            src[i] = (value < 0)? 0 : (value > 255)? 255 : value;
+        }
+    }
+    rasterFree(blur);
+    free(above);
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int boxBlur(PXL *, int *, int, int, int)
+ * 
+ * Description:
+ *   blurs the image in place with BOX_PASSES box filters, pass k with radius[k].
+ *   The rows are filtered one by one with a row sized buffer. The columns are
+ *   filtered in tiles of BOX_TILE bytes, from top to bottom, keeping only the
+ *   last radius + 1 source rows of the tile (the halo) in a ring buffer.
+ * Return:
+ *   returns 1 if successful; else 0.
+ *
+ *=================================================================================
+ */
+int boxBlur(PXL *img, int radius[], int channels, int width, int height)
+{
+    int             i;
+    int             k;
+    int             stride = width * channels;
+    int             status = 1;
+    int             widest = 0;
+    unsigned int    inv[BOX_PASSES];
+    PXL            *row;
+    PXL            *ring;
+    unsigned int   *sum;
+
+    for(k = 0 ; k < BOX_PASSES ; k++){
+        inv[k] = (1u << 24) / (2 * radius[k] + 1);
+        widest = (radius[k] > widest)? radius[k] : widest;
+    }
+
+    #pragma omp parallel private(row, k) reduction(&&:status)
+    {
+        row = (PXL*)malloc(stride);
+        #pragma omp for
+        for(i = 0 ; i < height ; i++){
+            if(row == NULL){
+                continue;
+            }
+            //ping pong between the row and the buffer, an odd count ends in the buffer
+            for(k = 0 ; k < BOX_PASSES ; k++){
+                if(k % 2 == 0){
+                    boxRow(row, img + (size_t) i * stride, width, channels, radius[k], inv[k]);
+                }else{
+                    boxRow(img + (size_t) i * stride, row, width, channels, radius[k], inv[k]);
+                }
+            }
+            if(BOX_PASSES % 2 == 1){
+                memcpy(img + (size_t) i * stride, row, stride);
+            }
+        }
+        status = (row != NULL);
+        free(row);
+    }
+    if(!status){
+        return 0;
+    }
+
+    #pragma omp parallel private(ring, sum, k) reduction(&&:status)
+    {
+        ring = (PXL*)malloc(BOX_TILE * (widest + 1));
+        sum = (unsigned int*)malloc(sizeof(unsigned int) * BOX_TILE);
+        #pragma omp for
+        for(i = 0 ; i < stride ; i += BOX_TILE){
+            for(k = 0 ; k < BOX_PASSES && ring != NULL && sum != NULL ; k++){
+                boxColumns(img, stride, i, (i + BOX_TILE < stride)? i + BOX_TILE : stride,
+                           height, radius[k], inv[k], ring, sum);
+            }
+        }
+        status = (ring != NULL && sum != NULL);
+        free(ring);
+        free(sum);
+    }
+    return status;
+}
+
+//=================================================================================
+// Function boxRadii() splits the gaussian of -blur<radius> into BOX_PASSES box
+// radii. The variance is (radius + 1) * (radius + 3) / 4: odd radii get the same
+// (radius + 1) / 2 box in every pass, even ones mix the two box sizes around it.
+//=================================================================================
+void boxRadii(int radius, int box[])
+{
+    double  variance = (radius + 1.0) * (radius + 3.0) / 4;
+    int     lower = (int) sqrt(12 * variance / BOX_PASSES + 1);
+    int     narrow;
+    int     k;
+
+    //ideal box width rounded down to odd, then as many of those as keep the variance
+    lower -= (lower % 2 == 0);
+    narrow = (int) floor((12 * variance - BOX_PASSES * (lower * lower + 4 * lower + 3)) / (-4.0 * lower - 4) + 0.5);
+    for(k = 0 ; k < BOX_PASSES ; k++){
+        box[k] = (k < narrow)? (lower - 1) / 2 : (lower + 1) / 2;
+    }
+}
+
+//=================================================================================
+// Function boxRow() runs one running-sum box filter over a row of interleaved
+// channels into dst. The border pixels repeat outside of the row.
+//=================================================================================
+void boxRow(PXL *dst, PXL *src, int width, int channels, int radius, unsigned int inv)
+{
+    int             x;
+    int             c;
+    unsigned int    sum;
+
+    for(c = 0 ; c < channels ; c++){
+        sum = src[c] * (radius + 1);
+        for(x = 1 ; x <= radius ; x++){
+            sum += src[((x < width)? x : width - 1) * channels + c];
+        }
+        for(x = 0 ; x < width ; x++){
+            dst[x * channels + c] = (sum * inv + (1u << 23)) >> 24;
+            sum += src[((x + radius + 1 < width)? x + radius + 1 : width - 1) * channels + c];
+            sum -= src[((x - radius > 0)? x - radius : 0) * channels + c];
+        }
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * void boxColumns(PXL *, int, int, int, int, int, unsigned int, PXL *, unsigned int *)
+ * 
+ * Description:
+ *   runs one running-sum box filter down the bytes x0 to x1 of every row, in
+ *   place. Row y is saved in ring[y % (radius + 1)] before it is overwritten
+ *   since rows y - radius to y are still needed by the sums below.
+ *
+ *=================================================================================
+ */
+void boxColumns(PXL *img, int stride, int x0, int x1, int height, int radius, unsigned int inv,
+                PXL *ring, unsigned int *sum)
+{
+    int     x;
+    int     y;
+    int     n = x1 - x0;
+    PXL    *row;
+    PXL    *add;
+    PXL    *sub;
+
+    #pragma omp simd
+    for(x = 0 ; x < n ; x++){
+        sum[x] = img[x0 + x] * (radius + 1);
+    }
+    for(y = 1 ; y <= radius ; y++){
+        add = img + (size_t) ((y < height)? y : height - 1) * stride + x0;
+        #pragma omp simd
+        for(x = 0 ; x < n ; x++){
+            sum[x] += add[x];
+        }
+    }
+
+    for(y = 0 ; y < height ; y++){
+        row = img + (size_t) y * stride + x0;
+        memcpy(ring + (y % (radius + 1)) * n, row, n);
+        #pragma omp simd
+        for(x = 0 ; x < n ; x++){
+            row[x] = (sum[x] * inv + (1u << 23)) >> 24;
+        }
+        if(y == height - 1){
+            break;
+        }
+        //rows below y are untouched, rows above come from the ring
+        add = img + (size_t) ((y + radius + 1 < height)? y + radius + 1 : height - 1) * stride + x0;
+        sub = ring + (((y - radius > 0)? y - radius : 0) % (radius + 1)) * n;
+        #pragma omp simd
+        for(x = 0 ; x < n ; x++){
+            sum[x] += add[x] - sub[x];
+        }
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * void flipHorizontal(fileType *, fileFormat *, int ,int );
+ * 
+ * Description:
+ *   flips the image horizontally
+ *                                    
+ *=================================================================================
+ */
+void flipHorizontal(fileType *out, fileFormat *src, int width, int height)
+{
+    int          i;
+    int          j;
+    fileFormat   temp;
+    
+    //holds the first address of the image
+    temp.ppm = out->format.ppm;
+    for(i=0; i < height; i++){
+        for(j = width-1; j>=0;j--){
+            memcpy(out->format.ppm, src->ppm + j + (size_t) i * width, sizeof(PPM));
+            out->format.ppm++;
+        }
+    }
+    //gets the first address of the image
+    out->format.ppm = temp.ppm;
+    
+}
+
+/*
+ *=================================================================================
+ *
+ * void flipVertical(fileType *, fileFormat *, int ,int )
+ * 
+ * Description:
+ *   flips the image vertically
+ *                                    
+ *=================================================================================
+ */
+void flipVertical(fileType *out, fileFormat *src,  int width, int height)
+{
+    int          i;
+    int          j;
+    fileFormat   temp;
+
+    //holds the first address of the image
+    temp.ppm = out->format.ppm;
+    for(i = height - 1; i >= 0; i--){
+        for(j = 0; j < width; j++){
+            memcpy(out->format.ppm, src->ppm + j + (size_t) i * width, sizeof(PPM));
+            out->format.ppm++;
+        }
+    }
+    //gets the first address of the image
+    out->format.ppm = temp.ppm;
+    
+}
+
+/*
+ *=================================================================================
+ *
+ * void flipHorizontalInPlace(fileFormat *, int ,int )
+ * 
+ * Description:
+ *   flips the image horizontally by reversing every row
+ *                                    
+ *=================================================================================
+ */
+void flipHorizontalInPlace(fileFormat *img, int width, int height)
+{
+    int     i;
+    int     j;
+    PPM     temp;
+    PPM     *row;
+
+    #pragma omp parallel for private(j, temp, row)
+    for(i = 0; i < height; i++){
+        row = img->ppm + (size_t) i * width;
+        for(j = 0; j < width / 2; j++){
+            temp = row[j];
+            row[j] = row[width - 1 - j];
+            row[width - 1 - j] = temp;
+        }
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * void flipVerticalInPlace(fileFormat *, int ,int )
+ * 
+ * Description:
+ *   flips the image vertically by swapping the top and bottom rows
+ *                                    
+ *=================================================================================
+ */
+void flipVerticalInPlace(fileFormat *img, int width, int height)
+{
+    int     i;
+    int     j;
+    PPM     temp;
+    PPM     *top;
+    PPM     *bottom;
+
+    #pragma omp parallel for private(j, temp, top, bottom)
+    for(i = 0; i < height / 2; i++){
+        top = img->ppm + (size_t) i * width;
+        bottom = img->ppm + (size_t) (height - 1 - i) * width;
+        for(j = 0; j < width; j++){
+            temp = top[j];
+            top[j] = bottom[j];
+            bottom[j] = temp;
+        }
+    }
+}
+
+//=================================================================================
+// Function rotate180InPlace() rotates the image in 180 degrees by reversing all
+// of the pixels.
+//=================================================================================
+void rotate180InPlace(fileFormat *img, int width, int height)
+{
+    size_t  i;
+    size_t  size = (size_t) width * height;
+    PPM     temp;
+
+    #pragma omp parallel for private(temp)
+    for(i = 0; i < size / 2; i++){
+        temp = img->ppm[i];
+        img->ppm[i] = img->ppm[size - 1 - i];
+        img->ppm[size - 1 - i] = temp;
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * int transposeInPlace(fileFormat *, int ,int )
+ * 
+ * Description:
+ *   transposes the image inside its own buffer. Square images swap pixel pairs.
+ *   Other sizes follow the permutation cycles (pixel k moves to k*height mod
+ *   size-1) and keep a 1 bit per pixel map of the visited pixels.
+ * Return:
+ *   returns 1 if successful; else 0.    
+ *
+ *=================================================================================
+ */
+int transposeInPlace(fileFormat *img, int width, int height)
+{
+    int                 i;
+    int                 j;
+    unsigned long long  size = (unsigned long long) width * height;
+    unsigned long long  start;
+    unsigned long long  cur;
+    unsigned char      *visited;
+    PPM                 temp;
+    PPM                 carry;
+
+    if(width == height){
+        #pragma omp parallel for private(j, temp)
+        for(i = 0; i < height; i++){
+            for(j = i + 1; j < width; j++){
+                temp = img->ppm[(size_t) i * width + j];
+                img->ppm[(size_t) i * width + j] = img->ppm[(size_t) j * width + i];
+                img->ppm[(size_t) j * width + i] = temp;
+            }
+        }
+        return 1;
+    }
+
+    visited = (unsigned char*)calloc((size + 7) / 8, 1);
+    if(visited == NULL){
+        return 0;
+    }
+    //the first and the last pixel never move
+    for(start = 1; start + 1 < size; start++){
+        if(visited[start >> 3] & (1 << (start & 7))){
+            continue;
+        }
+        carry = img->ppm[start];
+        cur = start;
+        do{
+            cur = (cur * height) % (size - 1);
+            temp = img->ppm[cur];
+            img->ppm[cur] = carry;
+            carry = temp;
+            visited[cur >> 3] |= 1 << (cur & 7);
+        }while(cur != start);
+    }
+    free(visited);
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * unsigned long long availMem()
+ * 
+ * Description:
+ *   gets the physical memory that is still available. On Linux it is
+ *   MemAvailable, which counts the page cache the kernel can drop; the free
+ *   pages alone look low on any machine that has been running for a while.
+ * Return:
+ *   returns the size in bytes; 0 if it is unknown.
+ *                                    
+ *=================================================================================
+ */
+unsigned long long availMem()
+{
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status)? status.ullAvailPhys : 0;
+#else
+#ifdef __linux__
+    FILE               *fp;
+    char                line[128];
+    unsigned long long  kB = 0;
+
+    if((fp = fopen("/proc/meminfo", "r")) != NULL){
+        while(fgets(line, sizeof(line), fp) != NULL && sscanf(line, "MemAvailable: %llu kB", &kB) != 1);
+        fclose(fp);
+        if(kB > 0){
+            return kB * 1024;
+        }
+    }
+#endif
+#ifdef _SC_AVPHYS_PAGES
+    {
+        long pages = sysconf(_SC_AVPHYS_PAGES);
+        long pageSize = sysconf(_SC_PAGESIZE);
+
+        return (pages > 0 && pageSize > 0)? (unsigned long long) pages * pageSize : 0;
+    }
+#else
+    return 0;
+#endif
+#endif
+}
+
+#ifdef PPMX_VERIFY
+//=========================================================================================
+//                                 Kernel Verification
+//-----------------------------------------------------------------------------------------
+//  Built with -DPPMX_VERIFY only. --verify[seed] runs every fast or in-place kernel next
+//  to the plain kernel it replaces on edge case and random sizes, and checks that the
+//  threaded loops give the same bytes with one thread and with all threads.
+//=========================================================================================
+
+//=================================================================================
+// Function verifyFill() fills the image with noise, or with a smooth random
+// gradient (plus a little noise) for the checks that allow a tolerance.
+//=================================================================================
+void verifyFill(PPM *img, int width, int height, int smooth)
+{
+    int     i;
+    int     j;
+    int     k;
+    double  slope[3][3];
+    double  v;
+    PXL    *p;
+
+    for(k = 0 ; k < 3 ; k++){
+        slope[k][0] = (rand() % 2001 - 1000) / 1000.0 * 255 / (width + 1);
+        slope[k][1] = (rand() % 2001 - 1000) / 1000.0 * 255 / (height + 1);
+        slope[k][2] = rand() % 256;
+    }
+    for(i = 0 ; i < height ; i++){
+        for(j = 0 ; j < width ; j++){
+            p = (PXL*) (img + i * width + j);
+            for(k = 0 ; k < 3 ; k++){
+                if(!smooth){
+                    p[k] = rand() % 256;
+                    continue;
+                }
+                v = slope[k][2] + slope[k][0] * j + slope[k][1] * i + rand() % 5 - 2;
+                //mirror back into 0 - 255 so there are no hard clamps
+                v = fmod(fabs(v), 510);
+                p[k] = (PXL) ((v > 255)? 510 - v : v);
+            }
+        }
+    }
+}
+
+/*
+ *=================================================================================
+ *
+ * int verifyCompare(char [], int, int, PBM *, PBM *, size_t, size_t)
+ * 
+ * Description:
+ *   compares a kernel variant byte by byte with the reference. Sizes have to
+ *   match and every byte has to be equal.
+ * Return:
+ *   returns 1 if they match; else 0.
+ *
+ *=================================================================================
+ */
+int verifyCompare(char name[], int width, int height, PBM *ref, PBM *got, size_t refSize, size_t gotSize)
+{
+    size_t  i;
+    size_t  cnt = 0;
+
+    if(refSize != gotSize){
+        fprintf(fpLog, "FAIL %-24s %5d x %-5d size %llu, expected %llu\n", name, width, height,
+                (unsigned long long) gotSize, (unsigned long long) refSize);
+        return 0;
+    }
+    for(i = 0 ; i < refSize ; i++){
+        cnt += (ref[i] != got[i]);
+    }
+    if(cnt != 0){
+        fprintf(fpLog, "FAIL %-24s %5d x %-5d %llu of %llu bytes differ\n", name, width, height,
+                (unsigned long long) cnt, (unsigned long long) refSize);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int verifyInterior(char [], int, int, PPM *, PPM *, double)
+ * 
+ * Description:
+ *   compares two interpolated images inside the rotated area only (pixels whose
+ *   reference and 4 neighbours are not background). Edges are treated differently
+ *   by each engine so they are skipped. The mean difference has to stay within
+ *   the tolerance.
+ * Return:
+ *   returns 1 if they match; else 0.
+ *
+ *=================================================================================
+ */
+int verifyInterior(char name[], int width, int height, PPM *ref, PPM *got, double tolerance)
+{
+    int     i;
+    int     j;
+    int     k;
+    int     cnt = 0;
+    double  sum = 0;
+    PPM    *p;
+
+    for(i = 1 ; i < height - 1 ; i++){
+        for(j = 1 ; j < width - 1 ; j++){
+            p = ref + i * width + j;
+            for(k = 0 ; k < 5 ; k++){
+                if(p->R == 0 && p->G == 0 && p->B == 0) break;
+                p = ref + i * width + j + ((k == 0)? -1 : (k == 1)? 1 : (k == 2)? -width : (k == 3)? width : 0);
+            }
+            if(k < 5){
+                continue;
+            }
+            p = ref + i * width + j;
+            sum += abs(p->R - got[i * width + j].R) + abs(p->G - got[i * width + j].G) +
+                   abs(p->B - got[i * width + j].B);
+            cnt += 3;
+        }
+    }
+    if(cnt > 0 && sum / cnt > tolerance){
+        fprintf(fpLog, "FAIL %-24s %5d x %-5d mean difference %.2f > %.2f\n", name, width, height, sum / cnt, tolerance);
+        return 0;
+    }
+    return 1;
+}
+
+//=================================================================================
+// Function verifyBoxBlur() is the plain reference of boxBlur(): every output
+// byte sums its whole window again, rows first and then columns.
+//=================================================================================
+void verifyBoxBlur(PXL *img, int box[], int channels, int width, int height)
+{
+    int             i;
+    int             j;
+    int             k;
+    int             pass;
+    int             radius;
+    int             stride = width * channels;
+    unsigned int    sum;
+    unsigned int    inv;
+    PXL            *copy = (PXL*)malloc(stride * height);
+
+    for(pass = 0 ; pass < 2 * BOX_PASSES ; pass++){
+        radius = box[pass % BOX_PASSES];
+        inv = (1u << 24) / (2 * radius + 1);
+        memcpy(copy, img, stride * height);
+        for(i = 0 ; i < height ; i++){
+            for(j = 0 ; j < stride ; j++){
+                for(sum = 0, k = -radius ; k <= radius ; k++){
+                    if(pass < BOX_PASSES){
+                        sum += copy[i * stride + ((j / channels + k < 0)? 0 : (j / channels + k >= width)?
+                                width - 1 : j / channels + k) * channels + j % channels];
+                    }else{
+                        sum += copy[((i + k < 0)? 0 : (i + k >= height)? height - 1 : i + k) * stride + j];
+                    }
+                }
+                img[i * stride + j] = (sum * inv + (1u << 23)) >> 24;
+            }
+        }
+    }
+    free(copy);
+}
+
+//=================================================================================
+// Function verifyConvolve() is the plain reference of -sharpen and -usm on a P6
+// image: src + amount% * (src - blur), the percent rounded down to 1/256 steps.
+//=================================================================================
+void verifyConvolve(PXL *img, int radius, int amount, int channels, int width, int height)
+{
+    size_t          i;
+    size_t          size = (size_t) width * height * channels;
+    int             box[BOX_PASSES];
+    int             value;
+    PXL            *blur = (PXL*)malloc(size);
+
+    memcpy(blur, img, size);
+    boxRadii(radius, box);
+    verifyBoxBlur(blur, box, channels, width, height);
+    for(i = 0 ; i < size ; i++){
+        value = img[i] + (int) floor(((img[i] - blur[i]) * (amount * 256 / 100) + 128) / 256.0);
+        img[i] = (value < 0)? 0 : (value > 255)? 255 : value;
+    }
+    free(blur);
+}
+
+//=================================================================================
+// Function verifyRescale() is the plain reference of rescaleWidth(): the loop of
+// the first release, one pixel at a time, with the last row and column reused
+// as their own neighbours (the first release read past them).
+//=================================================================================
+int verifyRescale(fileType *out, PPM *src, int newWidth, int width, int height)
+{
+    PPM     pxl[4];
+    PPM     temp;
+    int     x;
+    int     y;
+    int     xDiff;
+    int     yDiff;
+    int     i;
+    int     j;
+    size_t  index;
+    size_t  offset = 0;
+    float   xRatio;
+    float   yRatio;
+
+    rasterFree(out->format.ppm);
+    out->format.ppm = NULL;
+
+    headerInfo[0] = newWidth;
+    headerInfo[1] = (int) ceil((float)height / width * newWidth);
+    if(!allocMem(out)){
+        return 0;
+    }
+
+    xRatio = ( (float) width - 1) / headerInfo[0];
+    yRatio = ( (float) height - 1) / headerInfo[1];
+
+    for(i = 0; i < headerInfo[1]; i++ ){
+        for(j=0; j < headerInfo[0]; j++){
+
+            x = xRatio * j;
+            y = yRatio * i;
+            xDiff = (xRatio * j) - x;
+            yDiff = (yRatio * i) - y;
+
+            index = (size_t) y * width + x;
+
+            pxl[0] = src[index];
+            pxl[1] = src[index + (x + 1 < width)];
+            pxl[2] = src[index + ((y + 1 < height)? width : 0)];
+            pxl[3] = src[index + ((y + 1 < height)? width : 0) + (x + 1 < width)];
+
+            temp.R = (PXL) (pxl[0].R * (1 - xDiff) * (1 - yDiff) + pxl[1].R * xDiff * (1 - yDiff) +
+                    pxl[2].R * yDiff * (1 - xDiff) + pxl[3].R * (xDiff * yDiff));
+
+            temp.G = (PXL) (pxl[0].G * (1 - xDiff) * (1 - yDiff) + pxl[1].G * xDiff * (1 - yDiff) +
+                    pxl[2].G * yDiff * (1 - xDiff) + pxl[3].G * (xDiff * yDiff));
+
+            temp.B = (PXL) (pxl[0].B * (1 - xDiff) * (1 - yDiff) + pxl[1].B * xDiff * (1 - yDiff) +
+                    pxl[2].B * yDiff * (1 - xDiff) + pxl[3].B * (xDiff * yDiff));
+
+            out->format.ppm[offset++] = temp;
+        }
+    }
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int verifyRotate(fileType *, PPM *, int, int, int)
+ * 
+ * Description:
+ *   plain reference of rotateImage(): the untiled, single thread loop of the
+ *   first release. Quarter turns are the first release's rotate90() loop, 180
+ *   and 270 write it back to front (its flips of a turn come to that).
+ * Return:
+ *   returns 1 if successful; else 0.
+ *
+ *=================================================================================
+ */
+int verifyRotate(fileType *out, PPM *src, int angle, int width, int height)
+{
+    const double cnAngle = (angle * M_PI / 180);
+    int          i;
+    int          j;
+    int          x;
+    int          y;
+    int          iFloorX;
+    int          iCeilingX;
+    int          iFloorY;
+    int          iCeilingY;
+    int          iWidth;
+    int          iHeight;
+    size_t       k = 0;
+    size_t       size = (size_t) width * height;
+    double       fDistance;
+    double       fPolarAngle;
+    double       fTrueX;
+    double       fTrueY;
+    double       fDeltaX;
+    double       fDeltaY;
+    double       fTop[3];
+    double       fBottom[3];
+    PPM          color[4];
+    PPM         *out90;
+
+    iWidth  = ceil( abs(sin(cnAngle) * height) + abs(cos(cnAngle) * width));
+    iHeight = ceil( abs(sin(cnAngle) * width) + abs(cos(cnAngle) * height));
+    headerInfo[0] = iWidth;
+    headerInfo[1] = iHeight;
+
+    rasterFree(out->format.ppm);
+    out->format.ppm = NULL;
+    if(!allocMem(out)){
+        return 0;
+    }
+
+    if(angle == 0 || angle == 180){
+        for(k = 0 ; k < size ; k++){
+            out->format.ppm[k] = src[(angle == 0)? k : size - 1 - k];
+        }
+        return 1;
+    }
+    if(angle == 90 || angle == 270){
+        out90 = out->format.ppm;
+        for(i = 0 ; i < width ; i++){
+            for(j = height - 1 ; j >= 0 ; j--, k++){
+                out90[(angle == 90)? k : size - 1 - k] = src[i + (size_t) j * width];
+            }
+        }
+        return 1;
+    }
+
+    memset(out->format.ppm, 0, out->size);
+    for(i = 0 ; i < iHeight ; ++i){
+        for(j = 0 ; j < iWidth ; ++j){
+            x = j - iWidth / 2;
+            y = iHeight / 2 - i;
+
+            fDistance = sqrt( x * x + y * y);
+            if(x == 0){
+                fPolarAngle = (y < 0)? 1.5 * M_PI : 0.5 * M_PI;
+            }else{
+                fPolarAngle = atan2(y,x);
+            }
+            fPolarAngle += cnAngle;
+
+            fTrueX = fDistance * cos(fPolarAngle) + width / 2;
+            fTrueY = height / 2 - fDistance * sin(fPolarAngle);
+
+            iFloorX = floor(fTrueX);
+            iFloorY = floor(fTrueY);
+            iCeilingX = ceil(fTrueX);
+            iCeilingY = ceil(fTrueY);
+            if (iFloorX < 0 || iCeilingX < 0 || iFloorX >= width || iCeilingX >= width || iFloorY < 0 || iCeilingY < 0 || iFloorY >= height || iCeilingY >= height) continue;
+
+            fDeltaX = fTrueX - iFloorX;
+            fDeltaY = fTrueY - iFloorY;
+
+            //topleft, topright, bottomleft and bottomright
+            color[0] = src[iFloorX + (size_t) iFloorY * width];
+            color[1] = src[iCeilingX + (size_t) iFloorY * width];
+            color[2] = src[iFloorX + (size_t) iCeilingY * width];
+            color[3] = src[iCeilingX + (size_t) iCeilingY * width];
+
+            fTop[0] = (1 - fDeltaX) * color[0].R + fDeltaX * color[1].R;
+            fTop[1] = (1 - fDeltaX) * color[0].G + fDeltaX * color[1].G;
+            fTop[2] = (1 - fDeltaX) * color[0].B + fDeltaX * color[1].B;
+            fBottom[0] = (1 - fDeltaX) * color[2].R + fDeltaX * color[3].R;
+            fBottom[1] = (1 - fDeltaX) * color[2].G + fDeltaX * color[3].G;
+            fBottom[2] = (1 - fDeltaX) * color[2].B + fDeltaX * color[3].B;
+
+            out->format.ppm[j + (size_t) i * iWidth].R = round((1 - fDeltaY) * fTop[0] + fDeltaY * fBottom[0]);
+            out->format.ppm[j + (size_t) i * iWidth].G = round((1 - fDeltaY) * fTop[1] + fDeltaY * fBottom[1]);
+            out->format.ppm[j + (size_t) i * iWidth].B = round((1 - fDeltaY) * fTop[2] + fDeltaY * fBottom[2]);
+        }
+    }
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int verifyDither(PBM *, PPM *, int, int, int)
+ * 
+ * Description:
+ *   plain reference of -mono on a P6 image: gray and bayer loops of the first
+ *   release. With levels (--adaptive) the 0.5% points and the Otsu threshold
+ *   are found by counting the gray pixels again for every level, no histogram,
+ *   and every gray is stretched on its own before the bayer compare.
+ * Return:
+ *   returns 1 if successful; else 0.
+ *
+ *=================================================================================
+ */
+int verifyDither(PBM *out, PPM *src, int width, int height, int levels)
+{
+    size_t  k;
+    size_t  cnt;
+    size_t  size = (size_t) width * height;
+    size_t  clip = size / 200;
+    int     i;
+    int     j;
+    int     n;
+    int     g;
+    int     low = 0;
+    int     high = 255;
+    int     t = 128;
+    double  below;
+    double  above;
+    double  weight;
+    double  d;
+    double  best = -1;
+    PBM     pbm;
+    PGM    *gray = (PGM*)malloc(size);
+    int     bayer[4][4] = {{ 16, 143,  47, 175},
+                           {207,  79, 239, 111},
+                           { 63, 191,  31, 159},
+                           {255, 127, 223,  95}};
+
+    if(gray == NULL){
+        return 0;
+    }
+    for(k = 0 ; k < size ; k++){
+        gray[k] = ((src[k].R * 299) + (src[k].G * 587) + (src[k].B * 114))/1000;
+    }
+
+    if(levels){
+        for(low = 0 ; low < 255 ; low++){
+            for(cnt = 0, k = 0 ; k < size ; k++){
+                cnt += (gray[k] <= low);
+            }
+            if(cnt > clip) break;
+        }
+        for(high = 255 ; high > 0 ; high--){
+            for(cnt = 0, k = 0 ; k < size ; k++){
+                cnt += (gray[k] >= high);
+            }
+            if(cnt > clip) break;
+        }
+        //the split with the largest weights times squared distance of the class means
+        for(i = 0 ; i < 255 ; i++){
+            for(below = above = weight = 0, k = 0 ; k < size ; k++){
+                if(gray[k] <= i){
+                    weight++;
+                    below += gray[k];
+                }else{
+                    above += gray[k];
+                }
+            }
+            if(weight == 0 || weight == size) continue;
+            d = below / weight - above / (size - weight);
+            d *= d * weight * (size - weight);
+            if(d > best){
+                best = d;
+                t = i;
+            }
+        }
+        t = (t <= low)? low + 1 : (t >= high)? high - 1 : t;
+    }
+
+    for(i = 0 ; i < height ; i++){
+        for(j = 0 ; j < width ; ){
+            for(n = 128, pbm = 0 ; j < width && n > 0 ;  j++, n >>=1){
+                g = gray[j + (size_t) i * width];
+                if(levels && high - low >= 16){
+                    g = (g <= low)? 0 : (g >= high)? 255 : (g <= t)? (g - low) * 128 / (t - low) :
+                        128 + (g - t) * 127 / (high - t);
+                }
+                pbm = (g <= bayer[i % 4][j % 4])? pbm | n : pbm;
+            }
+            *out++ = pbm;
+        }
+    }
+    free(gray);
+    return 1;
+}
+
+/*
+ *=================================================================================
+ *
+ * int verifyStream(PPM *, int, int)
+ * 
+ * Description:
+ *   runs the row-local chains through streamFrame() and through processFrame()
+ *   and writeImage(), both into tmpfile()s, and compares the files byte by byte.
+ * Return:
+ *   returns the number of failed checks.
+ *
+ *=================================================================================
+ */
+int verifyStream(PPM *src, int width, int height)
+{
+    static const int  chains[3][3] = {{3, 2, 5}, {2, 6, 0}, {3, 0, 0}};
+    static const int  lengths[3] = {3, 2, 1};
+    int               c;
+    int               i;
+    int               fails = 0;
+    int               info[3] = {width, height, 255};
+    int               type[3];
+    int               param[3];
+    int               status;
+    long              refSize;
+    long              gotSize;
+    size_t            size = sizeof(PPM) * width * height;
+    char              name[32];
+    PBM              *ref;
+    PBM              *got;
+    FILE             *fpIn;
+    FILE             *fpRef;
+    FILE             *fpGot;
+    fileType          img;
+
+    for(c = 0 ; c < 3 ; c++){
+        for(i = 0 ; i < lengths[c] ; i++){
+            type[i] = chains[c][i];
+            param[i] = (type[i] == 3)? width / 2 + 1 : 0;
+        }
+        sprintf(name, "streamFrame chain %d", c + 1);
+        fpIn = tmpfile();
+        fpRef = tmpfile();
+        fpGot = tmpfile();
+        img.format.ppm = (PPM*)malloc(size);
+        img.size = size;
+        status = (fpIn != NULL && fpRef != NULL && fpGot != NULL && img.format.ppm != NULL &&
+                  fwrite(src, 1, size, fpIn) == size);
+
+        if(status){
+            memcpy(img.format.ppm, src, size);
+            memcpy(headerInfo, info, sizeof(info));
+            fType[0] = 'P';
+            fType[1] = '6';
+            status = processFrame(&img, lengths[c], type, param) && writeImage(fpRef, img);
+        }
+        if(status){
+            rewind(fpIn);
+            memcpy(headerInfo, info, sizeof(info));
+            fType[1] = '6';
+            status = streamFrame(fpIn, &fpGot, name, lengths[c], type, param);
+        }
+        if(status){
+            refSize = ftell(fpRef);
+            gotSize = ftell(fpGot);
+            ref = (PBM*)malloc(refSize + 1);
+            got = (PBM*)malloc(gotSize + 1);
+            rewind(fpRef);
+            rewind(fpGot);
+            status = (ref != NULL && got != NULL && fread(ref, 1, refSize, fpRef) == (size_t) refSize &&
+                      fread(got, 1, gotSize, fpGot) == (size_t) gotSize);
+            if(status){
+                fails += !verifyCompare(name, width, height, ref, got, refSize, gotSize);
+            }
+            free(ref);
+            free(got);
+        }
+        if(!status){
+            fprintf(fpLog, "FAIL %-24s %5d x %-5d could not run\n", name, width, height);
+            fails++;
+        }
+
+        rasterFree(img.format.ppm);
+        if(fpIn != NULL) fclose(fpIn);
+        if(fpRef != NULL) fclose(fpRef);
+        if(fpGot != NULL) fclose(fpGot);
+    }
+    return fails;
+}
+
+/*
+ *=================================================================================
+ *
+ * int verifySize(int, int)
+ * 
+ * Description:
+ *   runs every check on one image size
+ * Return:
+ *   returns the number of failed checks.
+ *
+ *=================================================================================
+ */
+int verifySize(int width, int height)
+{
+    static const int  angles[] = {17, 30, 45, 100, 135, 222, 290, 359};
+    static const int  rotations[] = {90, 180, 270, 30, 135, 290};
+    int               i;
+    int               type[1];
+    int               param[1];
+    int               fails = 0;
+    int               info[3] = {width, height, 255};
+    size_t            size = sizeof(PPM) * width * height;
+    char              name[32];
+    PPM              *src;
+    fileType          ref;
+    fileType          got;
+    fileFormat        copy;
+    fileType          conv;
+    size_t            k;
+    int               box[BOX_PASSES];
+    unsigned long long hist[256];
+
+    src = (PPM*)malloc(size);
+    copy.ppm = (PPM*)malloc(size);
+    ref.format.ppm = got.format.ppm = NULL;
+    if(src == NULL || copy.ppm == NULL){
+        free(src);
+        free(copy.ppm);
+        fprintf(fpLog, "FAIL %-24s %5d x %-5d out of memory\n", "setup", width, height);
+        return 1;
+    }
+
+//sets the geometry, a fresh copy of the source and an empty reference
+#define VERIFY_RESET()                                   \
+    {   memcpy(headerInfo, info, sizeof(info));          \
+        fType[0] = 'P';                                  \
+        fType[1] = '6';                                  \
+        memcpy(copy.ppm, src, size);                     \
+        rasterFree(ref.format.ppm);                      \
+        rasterFree(got.format.ppm);                      \
+        ref.format.ppm = got.format.ppm = NULL;          \
+        allocMem(&ref);                                  \
+    }
+
+    verifyFill(src, width, height, 0);
+
+    //flips: copying versions against the in-place ones
+    VERIFY_RESET();
+    flipVertical(&ref, &copy, width, height);
+    flipVerticalInPlace(&copy, width, height);
+    fails += !verifyCompare("flipVerticalInPlace", width, height, ref.format.pbm, copy.pbm, ref.size, size);
+
+    VERIFY_RESET();
+    flipHorizontal(&ref, &copy, width, height);
+    flipHorizontalInPlace(&copy, width, height);
+    fails += !verifyCompare("flipHorizontalInPlace", width, height, ref.format.pbm, copy.pbm, ref.size, size);
+
+    //quarter turns: rotateImage() against processInPlace()
+    for(i = 90 ; i < 360 ; i += 90){
+        VERIFY_RESET();
+        rotateImage(&ref, &copy, i, width, height);
+        got.size = size;
+        got.format.ppm = (PPM*)malloc(size);
+        memcpy(headerInfo, info, sizeof(info));
+        memcpy(got.format.ppm, src, size);
+        processInPlace(&got, 4, i);
+        sprintf(name, "rotate%d in place", i);
+        fails += !verifyCompare(name, width, height, ref.format.pbm, got.format.pbm, ref.size, got.size);
+    }
+
+    //-gray and -mono: separate buffers against compaction in place
+    VERIFY_RESET();
+    fType[1] = '5';
+    allocMem(&ref);
+    toGrayScale(&ref.format, &copy, width, height);
+    fType[1] = '6';
+    got.size = size;
+    got.format.ppm = copy.ppm;
+    processInPlace(&got, 6, 0);
+    copy.ppm = got.format.ppm;
+    got.format.ppm = NULL;
+    fails += !verifyCompare("toGrayScale in place", width, height, ref.format.pbm, copy.pbm, ref.size, got.size);
+    copy.ppm = (PPM*)rasterRealloc(copy.ppm, size);
+
+    //-mono and --adaptive -mono: processFrame() copying and in place against the
+    //plain loops, the levels counted on the way against counting them again
+    for(i = 0 ; i < 4 ; i++){
+        VERIFY_RESET();
+        adaptive = i / 2;
+        inPlace = i % 2;
+        memset(&luma, 0, sizeof(luma));
+        verifyDither(ref.format.pbm, src, width, height, adaptive);
+        got.size = size;
+        got.format.ppm = copy.ppm;
+        type[0] = 5;
+        param[0] = 0;
+        processFrame(&got, 1, type, param);
+        copy.ppm = got.format.ppm;
+        got.format.ppm = NULL;
+        sprintf(name, "%sdithering%s", adaptive? "adaptive " : "", inPlace? " in place" : "");
+        fails += !verifyCompare(name, width, height, ref.format.pbm, copy.pbm,
+                                (size_t) height * ((width + 7) / 8), got.size);
+        copy.ppm = (PPM*)rasterRealloc(copy.ppm, size);
+    }
+    adaptive = 0;
+    inPlace = 0;
+
+    //-w and -r against the loops of the first release
+    for(i = 0 ; i < 2 ; i++){
+        VERIFY_RESET();
+        verifyRescale(&ref, src, (i == 0)? width / 2 + 1 : 2 * width + 3, width, height);
+        memcpy(headerInfo, info, sizeof(info));
+        rescaleWidth(&got, &copy, (i == 0)? width / 2 + 1 : 2 * width + 3, width, height);
+        sprintf(name, "rescaleWidth %s", (i == 0)? "down" : "up");
+        fails += !verifyCompare(name, width, height, ref.format.pbm, got.format.pbm, ref.size, got.size);
+    }
+    for(i = 0 ; i < (int)(sizeof(rotations) / sizeof(rotations[0])) ; i++){
+        //the canvas of a long strip turned a little is huge
+        if(rotations[i] % 90 != 0 && (width > 1000 || height > 1000)){
+            continue;
+        }
+        VERIFY_RESET();
+        verifyRotate(&ref, src, rotations[i], width, height);
+        memcpy(headerInfo, info, sizeof(info));
+        rotateImage(&got, &copy, rotations[i], width, height);
+        sprintf(name, "rotateImage %d", rotations[i]);
+        fails += !verifyCompare(name, width, height, ref.format.pbm, got.format.pbm, ref.size, got.size);
+    }
+
+    //the row stream has to write the same file as the whole frame
+    fails += verifyStream(src, width, height);
+
+    //--stats: the per-thread histograms of toGrayScale() against a recount of its
+    //output, then lumaHistogram() on the color source has to count the same again
+    VERIFY_RESET();
+    fType[1] = '5';
+    allocMem(&ref);
+    statsMode = 1;
+    memset(&luma, 0, sizeof(luma));
+    memset(hist, 0, sizeof(hist));
+    toGrayScale(&ref.format, &copy, width, height);
+    for(k = 0 ; k < ref.size ; k++){
+        hist[ref.format.pgm[k]]++;
+    }
+    fails += !verifyCompare("toGrayScale histogram", width, height, (PBM*)hist, (PBM*)luma.hist, sizeof(hist), sizeof(hist));
+    memset(&luma, 0, sizeof(luma));
+    lumaHistogram(&copy, width, height);
+    fails += !verifyCompare("lumaHistogram", width, height, (PBM*)hist, (PBM*)luma.hist, sizeof(hist), sizeof(hist));
+    statsMode = 0;
+
+    //running-sum blur against whole window sums, color and gray, mixed box sizes
+    //(even -blur radius) and a long radius
+    for(i = 2 ; i < 22 ; i += 19){
+        boxRadii(i, box);
+        VERIFY_RESET();
+        memcpy(ref.format.ppm, src, size);
+        verifyBoxBlur(ref.format.pbm, box, 3, width, height);
+        boxBlur(copy.pbm, box, 3, width, height);
+        sprintf(name, "boxBlur radius %d", i);
+        fails += !verifyCompare(name, width, height, ref.format.pbm, copy.pbm, ref.size, size);
+
+        VERIFY_RESET();
+        memcpy(ref.format.ppm, src, size);
+        verifyBoxBlur(ref.format.pbm, box, 1, width * 3, height);
+        boxBlur(copy.pbm, box, 1, width * 3, height);
+        sprintf(name, "boxBlur gray radius %d", i);
+        fails += !verifyCompare(name, width, height, ref.format.pbm, copy.pbm, ref.size, size);
+    }
+
+    //fixed point -sharpen150 and -usm2,80 against the plain formula
+    for(i = 0 ; i < 2 ; i++){
+        VERIFY_RESET();
+        memcpy(ref.format.ppm, src, size);
+        verifyConvolve(ref.format.pbm, (i == 0)? 1 : 2, (i == 0)? 150 : 80, 3, width, height);
+        conv.format = copy;
+        conv.size = size;
+        convolve(&conv, (i == 0)? 8 : 9, (i == 0)? 150 : 2080);
+        fails += !verifyCompare((i == 0)? "convolve sharpen" : "convolve usm", width, height,
+                                ref.format.pbm, copy.pbm, ref.size, size);
+    }
+
+    //3-shear rotation against bilinear, on smooth content since the engines differ
+    if(width >= 8 && height >= 8){
+        verifyFill(src, width, height, 1);
+        for(i = 0 ; i < (int)(sizeof(angles) / sizeof(angles[0])) ; i++){
+            VERIFY_RESET();
+            rotateImage(&ref, &copy, angles[i], width, height);
+            memcpy(headerInfo, info, sizeof(info));
+            rotateShear(&got, &copy, angles[i], width, height);
+            sprintf(name, "rotateShear %d", angles[i]);
+            if(ref.size != got.size){
+                fprintf(fpLog, "FAIL %-24s %5d x %-5d size %llu, expected %llu\n", name, width, height,
+                        (unsigned long long) got.size, (unsigned long long) ref.size);
+                fails++;
+            }else{
+                fails += !verifyInterior(name, headerInfo[0], headerInfo[1], ref.format.ppm, got.format.ppm, 3.0);
+            }
+        }
+        verifyFill(src, width, height, 0);
+    }
+
+#ifdef _OPENMP
+    //threaded loops: one thread has to give the same bytes as all threads
+    conv.format = copy;
+    conv.size = size;
+    boxRadii(10, box);
+    for(i = 0 ; i < 8 ; i++){
+        //the bilinear rotation of a long strip is a huge canvas
+        if(i == 5 && (width > 1000 || height > 1000)){
+            continue;
+        }
+        VERIFY_RESET();
+        omp_set_num_threads(1);
+        switch(i){
+            case 0: rotateShear(&ref, &copy, 33, width, height); break;
+            case 1: flipHorizontalInPlace(&copy, width, height); break;
+            case 2: flipVerticalInPlace(&copy, width, height); break;
+            case 3: rotate180InPlace(&copy, width, height); break;
+            case 4: boxBlur(copy.pbm, box, 3, width, height); break;
+            case 5: rotateImage(&ref, &copy, 33, width, height); break;
+            case 6: rescaleWidth(&ref, &copy, width / 2 + 1, width, height); break;
+            case 7: convolve(&conv, 9, 4150); break;
+        }
+        if((i > 0 && i < 5) || i == 7){
+            memcpy(ref.format.ppm, copy.ppm, size);
+            memcpy(copy.ppm, src, size);
+        }
+        memcpy(headerInfo, info, sizeof(info));
+        omp_set_num_threads(omp_get_num_procs() > 1 ? omp_get_num_procs() : 4);
+        switch(i){
+            case 0: rotateShear(&got, &copy, 33, width, height); break;
+            case 1: flipHorizontalInPlace(&copy, width, height); break;
+            case 2: flipVerticalInPlace(&copy, width, height); break;
+            case 3: rotate180InPlace(&copy, width, height); break;
+            case 4: boxBlur(copy.pbm, box, 3, width, height); break;
+            case 5: rotateImage(&got, &copy, 33, width, height); break;
+            case 6: rescaleWidth(&got, &copy, width / 2 + 1, width, height); break;
+            case 7: convolve(&conv, 9, 4150); break;
+        }
+        if((i > 0 && i < 5) || i == 7){
+            got.format.ppm = (PPM*)malloc(size);
+            got.size = size;
+            memcpy(got.format.ppm, copy.ppm, size);
+        }
+        sprintf(name, "threads %s", (i == 0)? "rotateShear" : (i == 1)? "flipHorizontalInPlace" :
+                                    (i == 2)? "flipVerticalInPlace" : (i == 3)? "rotate180InPlace" :
+                                    (i == 4)? "boxBlur" : (i == 5)? "rotateImage" :
+                                    (i == 6)? "rescaleWidth" : "convolve usm");
+        fails += !verifyCompare(name, width, height, ref.format.pbm, got.format.pbm, ref.size, got.size);
+    }
+#endif
+
+#undef VERIFY_RESET
+    rasterFree(ref.format.ppm);
+    rasterFree(got.format.ppm);
+    free(copy.ppm);
+    free(src);
+    return fails;
+}
+
+/*
+ *=================================================================================
+ *
+ * int verifyKernels(unsigned int)
+ * 
+ * Description:
+ *   runs verifySize() on the edge case sizes and on random sizes from the seed
+ * Return:
+ *   returns 1 if every check passed; else 0.
+ *
+ *=================================================================================
+ */
+int verifyKernels(unsigned int seed)
+{
+    static const int  sizes[][2] = {{1, 1}, {1, 37}, {37, 1}, {2, 2}, {3, 5}, {7, 7}, {8, 8},
+                                    {9, 16}, {63, 17}, {64, 64}, {101, 99}, {9999, 2}, {2, 9999},
+                                    {10007, 2}, {2, 10007}, {65, 129}};
+    static const int  mappedSizes[][2] = {{1, 37}, {65, 129}, {101, 99}, {10007, 2}};
+    int               i;
+    int               w;
+    int               h;
+    int               fails = 0;
+
+    srand(seed);
+    fprintf(fpLog, "verifying kernels, seed %u\n", seed);
+    for(i = 0 ; i < (int)(sizeof(sizes) / sizeof(sizes[0])) ; i++){
+        fails += verifySize(sizes[i][0], sizes[i][1]);
+    }
+    for(i = 0 ; i < 24 ; i++){
+        w = 1 + rand() % 300;
+        h = 1 + rand() % 300;
+        fails += verifySize(w, h);
+    }
+    //again with every raster in a mapped temp file (--mapped)
+    mapFrom = 1;
+    for(i = 0 ; i < (int)(sizeof(mappedSizes) / sizeof(mappedSizes[0])) ; i++){
+        fails += verifySize(mappedSizes[i][0], mappedSizes[i][1]);
+    }
+    mapFrom = 0;
+    fprintf(fpLog, "%d failed check(s)\n", fails);
+    return fails == 0;
+}
+#endif
+
+/*
+ *=================================================================================
+ *
+ * void options()
+ * 
+ * Description:
+ *   displays usage of the program
+ *                                    
+ *=================================================================================
+ */
+void options()
+{
+    fprintf(fpLog, "\nUsage: ppmx [--inplace] [--mapped] [--stats] [--adaptive] [--out-ppm|pgm|pbm <path>] [-o <path>] [options] (filename.ppm | -)");
+    fprintf(fpLog, "\n       ppmx --watch <folder> -o <folder> [options]");
+    fprintf(fpLog, "\nOptions:\n-fv\t\tFlip vertically");
+    fprintf(fpLog, "\n-fh\t\tFlip horizontally");
+    fprintf(fpLog, "\n-w<width>\tScale to the new width");
+    fprintf(fpLog, "\n-r<angle>\tRotate CW (0 - 359)");
+    fprintf(fpLog, "\n-rb<angle>\tRotate CW using bilinear interpolation");
+    fprintf(fpLog, "\n-rs<angle>\tRotate CW using 3 shears (default from %d pixels)", SHEAR_MIN_PIXELS);
+    fprintf(fpLog, "\n-rc<angle>\tRotate CW using 3 shears and report the difference to bilinear");
+    fprintf(fpLog, "\n-blur<radius>\tBlur (1 - 999)");
+    fprintf(fpLog, "\n-sharpen<amount>\tSharpen by amount %% (0 - 999)");
+    fprintf(fpLog, "\n-usm<radius>[,<amount>]\tUnsharp mask (amount defaults to 100%%)");
+    fprintf(fpLog, "\n-mono\t\tConvert to bilevel (.pbm)format");
+    fprintf(fpLog, "\n-gray\t\tConvert to grayscale (.pgm) format");
+    fprintf(fpLog, "\n--inplace\tKeep a single raster in memory (automatic when memory is low)");
+    fprintf(fpLog, "\n--mapped\tKeep the rasters in temp files the system can page out (automatic for huge images)");
+    fprintf(fpLog, "\n--stats\t\tPrint the luma min, max, mean, levels and threshold of every frame");
+    fprintf(fpLog, "\n--adaptive\tLevel -mono and --out-pbm to the image and dither around its own threshold");
+    fprintf(fpLog, "\n-o <path>\tWrite the result to path (- is stdout, the default for - as input)");
+    fprintf(fpLog, "\n--watch <folder>\tProcess every file written into the folder (Linux), -o is the output folder");
+    fprintf(fpLog, "\n--out-ppm <path>\tWrite the color result to path (- is stdout)");
+    fprintf(fpLog, "\n--out-pgm <path>\tWrite the grayscale result to path");
+    fprintf(fpLog, "\n--out-pbm <path>\tWrite the bilevel result to path\n");
+}
+